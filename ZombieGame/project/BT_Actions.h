@@ -276,7 +276,7 @@ namespace BT_Actions
 		return FAILURE;
 	}
 
-	Elite::BehaviorState ChangeToExploreArea(Elite::Blackboard* pBlackboard, std::unordered_set<int> area)
+	Elite::BehaviorState ChangeToExploreArea(Elite::Blackboard* pBlackboard, const std::unordered_set<int>& area)
 	{
 		auto pSurvivor{ GetSurvivor(pBlackboard) };
 		if (!pSurvivor)
@@ -348,7 +348,7 @@ namespace BT_Actions
 
 		// Continue navigating influence map whilst in danger
 		const float errorMargin{ 5.0f };
-		const float currentNodeInfluence{ pInfluenceMap->GetNodeAtWorldPos(pSurvivor->GetLocation())->GetInfluence() };
+		const float currentNodeInfluence{ pInfluenceMap->GetInfluenceAtPosition(pSurvivor->GetLocation(), InfluenceLayer::DANGER) };
 		if (currentNodeInfluence < -errorMargin)
 		{
 			pSurvivor->SetToNavigateInfluenceMap();
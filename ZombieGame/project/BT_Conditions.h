@@ -139,17 +139,19 @@ namespace BT_Conditions
 		//check influence on neighboring squares 
 		const auto& node = pInfluenceMap->GetNodeAtWorldPos(pInterface->Agent_GetInfo().Location);
 		float scannedCount{ 0 };
+		int neighborCount{ 0 };
 
-		for (const auto& connection : pInfluenceMap->GetConnections(node->GetIndex()))
-		{
-			if (pInfluenceMap->GetNode(connection->GetTo())->GetScanned())
-				++scannedCount;
-		}
+		pInfluenceMap->ForEachNeighbor(node->GetIndex(), [&](int neighborIdx, float)
+			{
+				++neighborCount;
+				if (pInfluenceMap->IsScanned(neighborIdx))
+					++scannedCount;
+			});
 
-		if (scannedCount < pInfluenceMap->GetConnections(node->GetIndex()).size() / 2)
+		if (scannedCount < neighborCount / 2)
 			std::cout << "Area not scanned\n";
 
-		return scannedCount > pInfluenceMap->GetConnections(node->GetIndex()).size() / 2;
+		return scannedCount > neighborCount / 2;
 	}
 
 	bool IsDangerNear(Elite::Blackboard* pBlackboard)
@@ -162,19 +164,11 @@ namespace BT_Conditions
 		if (!pSurvivor)
 			return false;
 
-		//Get nodes around fov radius
-		const auto& nodes = pMemory->GetInfluenceMap()->GetNodeIndicesInRadius(pSurvivor->GetLocation(), pSurvivor->GetInfo().FOV_Range * 2);
-
+		//Check the lowest danger around fov radius
 		const float errorMargin{ 5.0f };
-		for (const auto& node : nodes)
-		{
-			if (pMemory->GetInfluenceMap()->GetNode(node)->GetInfluence() < -errorMargin)
-			{
-				return true;
-			}
-		}
+		const float lowestDanger{ pMemory->GetInfluenceMap()->GetMinInfluenceInRadius(pSurvivor->GetLocation(), pSurvivor->GetInfo().FOV_Range * 2, InfluenceLayer::DANGER) };
 
-		return false;
+		return lowestDanger < -errorMargin;
 	}
 
 	bool SeesPurgeZone(Elite::Blackboard* pBlackboard)
@@ -200,24 +194,16 @@ namespace BT_Conditions
 		if (!pInterface)
 			return false;
 
-		//check influence on neighboring squares 
-		const auto& nodes = pInfluenceMap->GetNodeIndicesInRadius(pInterface->Agent_GetInfo().Location, pInterface->Agent_GetInfo().FOV_Range * 2);
-
-		float scannedCount{ 0 };
+		// Houses to clear and located items both count as reward
+		std::vector<float> layerWeights(InfluenceLayer::COUNT, 0.f);
+		layerWeights[InfluenceLayer::REWARD] = 1.f;
+		layerWeights[InfluenceLayer::LOOT] = 1.f;
 
+		//check influence around fov radius, a cell further so the neighbours of the border cells count too
+		const float radius{ pInterface->Agent_GetInfo().FOV_Range * 2 + pInfluenceMap->GetCellSize() * 1.5f };
 		const float errorMargin{ 5.0f };
-		for (const auto& node : nodes)
-		{
-			for (const auto& connection : pInfluenceMap->GetNodeConnections(node))
-			{
-				if (pInfluenceMap->GetNode(connection->GetTo())->GetInfluence() > errorMargin)
-				{
-					return true;
-				}
-			}
-		}
 
-		return false;
+		return pInfluenceMap->GetMaxInfluenceInRadius(pInterface->Agent_GetInfo().Location, radius, layerWeights) > errorMargin;
 	}
 
 	bool HasSeenItem(Elite::Blackboard* pBlackboard)
@@ -238,8 +224,8 @@ namespace BT_Conditions
 		const auto& locatedItems{ pMemory->GetLocatedItems() };
 		for (const auto& item : locatedItems)
 		{
-			if (pMemory->GetInfluenceMap()->GetNode(item)->GetItem() == eItemType::PISTOL
-				|| pMemory->GetInfluenceMap()->GetNode(item)->GetItem() == eItemType::SHOTGUN)
+			if (pMemory->GetInfluenceMap()->GetItemType(item) == eItemType::PISTOL
+				|| pMemory->GetInfluenceMap()->GetItemType(item) == eItemType::SHOTGUN)
 				return true;
 		}
 
@@ -146,6 +146,10 @@ namespace BT_ObjectGetters
 		const auto& agentInfo{ pSurvivor->GetInfo() };
 		for (auto& item : items)
 		{
+			// Skip the items danger cuts the agent off from
+			if (!pMemory->IsReachable(item))
+				continue;
+
 			const auto& itemNode{ pInfluenceMap->GetNode(item) };
 
 			if (agentInfo.Location.DistanceSquared(itemNode->GetPosition()) <
@@ -180,20 +184,24 @@ namespace BT_ObjectGetters
 		const auto& agentInfo{ pSurvivor->GetInfo() };
 		for (auto& itemIdx : itemIndices)
 		{
+			if (!pMemory->IsReachable(itemIdx))
+				continue;
+
 			const auto& itemNode{ pInfluenceMap->GetNode(itemIdx) };
+			const eItemType itemType{ pInfluenceMap->GetItemType(itemIdx) };
 
-			if (itemNode->GetItem() == eItemType::INVALID)
+			if (itemType == eItemType::INVALID)
 				continue;
 
 			// If needed type is a weapon but item on node is not, continue
 			if (type == eItemType::WEAPON &&
-				!(itemNode->GetItem() == eItemType::PISTOL
-					|| itemNode->GetItem() == eItemType::SHOTGUN))
+				!(itemType == eItemType::PISTOL
+					|| itemType == eItemType::SHOTGUN))
 				continue;
 
 			// Continue if item on node is not needed type
 			// Ignore when need a weapon, since the item on node will never be "weapon"
-			if (type != eItemType::WEAPON && itemNode->GetItem() != type)
+			if (type != eItemType::WEAPON && itemType != type)
 				continue;
 
 			if (agentInfo.Location.DistanceSquared(itemNode->GetPosition()) <
@@ -0,0 +1,73 @@
+#include "../stdafx.h"
+#include "Benchmarks.h"
+#include "../framework/EliteAI/EliteGraphs/EGridGraph.h"
+#include "../framework/EliteAI/EliteGraphs/EliteGraphAlgorithms/EAStar.h"
+
+namespace
+{
+	using Grid = Elite::GridGraph<Elite::WorldNode, Elite::GraphConnection>;
+	using Search = Elite::AStar<Elite::WorldNode, Elite::GraphConnection>;
+
+	float NoHeuristic(float, float)
+	{
+		return 0.f;
+	}
+
+	float GetPathCost(const Grid& grid, const std::vector<Elite::WorldNode*>& path)
+	{
+		float cost{ 0.f };
+		for (size_t i = 1; i < path.size(); ++i)
+			cost += grid.GetConnection(path[i - 1]->GetIndex(), path[i]->GetIndex())->GetCost();
+		return cost;
+	}
+}
+
+// AStar from corner to corner over 8-connected grids with a fifth of the cells cut off (costs 1 and 1.5, Octile heuristic).
+// The path cost is checked against a search without heuristic, which is Dijkstra
+void Benchmarks::RunAStar()
+{
+	const int nrOfSearches{ 3 };
+
+	printf("corner to corner, 20%% of the cells blocked, Octile heuristic\n");
+
+	for (int size : { 100, 200, 500 })
+	{
+		Grid grid{ false };
+		grid.InitializeGrid({ 0.f, 0.f }, size, size, 1, false, true, 1.f, 1.5f);
+
+		// a blocked cell loses all its connections, the corners stay open
+		std::mt19937 random{ 7 };
+		std::uniform_real_distribution<float> blockDistribution{ 0.f, 1.f };
+		std::vector<int> neighbors{};
+		for (int idx = 1; idx < size * size - 1; ++idx)
+		{
+			if (blockDistribution(random) >= .2f)
+				continue;
+
+			neighbors.clear();
+			for (const Elite::GraphConnection* pConnection : grid.GetNodeConnections(idx))
+				neighbors.push_back(pConnection->GetTo());
+			for (int neighborIdx : neighbors)
+			{
+				grid.RemoveConnection(idx, neighborIdx);
+				grid.RemoveConnection(neighborIdx, idx);
+			}
+		}
+
+		Search search{ &grid, Elite::HeuristicFunctions::Octile };
+		Elite::WorldNode* pStart{ grid.GetNode(0) };
+		Elite::WorldNode* pGoal{ grid.GetNode(size * size - 1) };
+		std::vector<Elite::WorldNode*> path{ search.FindPath(pStart, pGoal) };
+
+		Stopwatch stopwatch{};
+		for (int i = 0; i < nrOfSearches; ++i)
+			path = search.FindPath(pStart, pGoal);
+		const double searchMs{ stopwatch.GetElapsedMs() / nrOfSearches };
+
+		Search dijkstra{ &grid, NoHeuristic };
+		const std::vector<Elite::WorldNode*> dijkstraPath{ dijkstra.FindPath(pStart, pGoal) };
+
+		printf("  %4dx%-4d  %8.2f ms/search  path of %zu nodes, cost %.2f (Dijkstra %.2f)\n", size, size, searchMs,
+			path.size(), GetPathCost(grid, path), GetPathCost(grid, dijkstraPath));
+	}
+}
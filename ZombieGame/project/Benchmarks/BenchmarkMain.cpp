@@ -0,0 +1,75 @@
+// Doesn't include stdafx.h: SDL renames main on Windows
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "Benchmarks.h"
+
+namespace
+{
+	long long g_NrOfAllocations{ 0 };
+}
+
+// Every allocation of the program goes through here, so a benchmark can count the ones its code makes
+void* operator new(size_t size)
+{
+	++g_NrOfAllocations;
+	if (void* pMemory = malloc(size == 0 ? 1 : size))
+		return pMemory;
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* pMemory) noexcept
+{
+	free(pMemory);
+}
+
+long long Benchmarks::GetNrOfAllocations()
+{
+	return g_NrOfAllocations;
+}
+
+namespace
+{
+	struct Benchmark
+	{
+		const char* name;
+		void(*run)();
+	};
+
+	const Benchmark g_Benchmarks[]
+	{
+		{ "pathrepair", Benchmarks::RunPathRepair },
+		{ "gridkernel", Benchmarks::RunGridKernel },
+		{ "fixedpoint", Benchmarks::RunFixedPoint },
+		{ "gridqueries", Benchmarks::RunGridQueries },
+		{ "nodelayouts", Benchmarks::RunNodeLayouts },
+		{ "graphpool", Benchmarks::RunGraphPool },
+		{ "nodeviews", Benchmarks::RunNodeViews },
+		{ "astar", Benchmarks::RunAStar },
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	bool hasRun{ false };
+	for (const Benchmark& benchmark : g_Benchmarks)
+	{
+		if (argc > 1 && strcmp(argv[1], benchmark.name) != 0)
+			continue;
+
+		printf("--- %s\n", benchmark.name);
+		benchmark.run();
+		hasRun = true;
+	}
+
+	if (!hasRun)
+	{
+		printf("No benchmark called %s, pick one of:", argv[1]);
+		for (const Benchmark& benchmark : g_Benchmarks)
+			printf(" %s", benchmark.name);
+		printf("\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <chrono>
+
+// Benchmarks for the graph and influence map code behind the agent, built into GPP_Benchmarks.exe.
+// They only use the framework headers, so they run without the game. Build Release, the Debug numbers mean nothing.
+// GPP_Benchmarks.exe runs them all, GPP_Benchmarks.exe <name> only the one with that name.
+namespace Benchmarks
+{
+	class Stopwatch
+	{
+	public:
+		Stopwatch() : m_Start{ std::chrono::high_resolution_clock::now() } {}
+
+		void Restart() { m_Start = std::chrono::high_resolution_clock::now(); }
+		double GetElapsedMs() const { return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - m_Start).count(); }
+		double GetElapsedUs() const { return std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - m_Start).count(); }
+
+	private:
+		std::chrono::high_resolution_clock::time_point m_Start;
+	};
+
+	// operator new calls since the start, BenchmarkMain replaces it
+	long long GetNrOfAllocations();
+
+	void RunPathRepair();
+	void RunGridKernel();
+	void RunFixedPoint();
+	void RunGridQueries();
+	void RunNodeLayouts();
+	void RunGraphPool();
+	void RunNodeViews();
+	void RunAStar();
+}
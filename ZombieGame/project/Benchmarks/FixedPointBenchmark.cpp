@@ -0,0 +1,84 @@
+#include "../stdafx.h"
+#include "Benchmarks.h"
+#include "../framework/EliteAI/EliteGraphs/EGridGraph.h"
+#include "../framework/EliteAI/EliteGraphs/EInfluenceMap.h"
+
+namespace
+{
+	using InfluenceGrid = Elite::GridGraph<Elite::WorldNode, Elite::GraphConnection>;
+
+	template <class T_InfluencePolicy>
+	void SetUpMap(Elite::InfluenceMap<InfluenceGrid, T_InfluencePolicy>& influenceMap, int size, int nrOfLayers)
+	{
+		influenceMap.SetNrOfLayers(nrOfLayers);
+		influenceMap.SetUseImplicitConnections(true);
+		influenceMap.InitializeGrid({ 0.f, 0.f }, size, size, 3, false, true);
+		influenceMap.InitializeBuffer();
+		influenceMap.SetChangeThreshold(0.f); // all tiles stay awake
+		for (int layer = 0; layer < nrOfLayers; ++layer)
+		{
+			influenceMap.SetDecay(layer, .1f + .1f * layer);
+			influenceMap.SetMomentum(layer, .2f + .1f * layer);
+		}
+
+		std::mt19937 random{ 1 };
+		std::uniform_int_distribution<int> cellDistribution{ 0, size * size - 1 };
+		std::uniform_int_distribution<int> layerDistribution{ 0, nrOfLayers - 1 };
+		std::uniform_real_distribution<float> influenceDistribution{ -100.f, 100.f };
+		for (int i = 0; i < size * size / 100; ++i)
+		{
+			const int idx{ cellDistribution(random) };
+			const int layer{ layerDistribution(random) };
+			influenceMap.SetInfluenceAtPosition(idx, influenceDistribution(random), layer);
+		}
+	}
+
+	template <class T_InfluencePolicy>
+	double TimeTicks(Elite::InfluenceMap<InfluenceGrid, T_InfluencePolicy>& influenceMap, int nrOfTicks)
+	{
+		Benchmarks::Stopwatch stopwatch{};
+		for (int tick = 0; tick < nrOfTicks; ++tick)
+			influenceMap.PropagateInfluence(1.f);
+		return stopwatch.GetElapsedMs() / nrOfTicks;
+	}
+}
+
+// FloatInfluence against FixedPointInfluence (Q8.8) on the same seeds, every tile awake, and how far the int16 map drifts off the float one
+void Benchmarks::RunFixedPoint()
+{
+	const int size{ 512 };
+	const int nrOfLayers{ 4 };
+	const int nrOfTicks{ 30 };
+
+	Elite::InfluenceMap<InfluenceGrid, Elite::FloatInfluence> floatMap{ false };
+	Elite::InfluenceMap<InfluenceGrid, Elite::FixedPointInfluence> fixedPointMap{ false };
+	SetUpMap(floatMap, size, nrOfLayers);
+	SetUpMap(fixedPointMap, size, nrOfLayers);
+
+	const double floatMs{ TimeTicks(floatMap, nrOfTicks) };
+	const double fixedPointMs{ TimeTicks(fixedPointMap, nrOfTicks) };
+
+	double errorSum{ 0. };
+	float maxError{ 0.f };
+	long long nrOfCellsOff{ 0 };
+	for (int layer = 0; layer < nrOfLayers; ++layer)
+	{
+		for (int idx = 0; idx < size * size; ++idx)
+		{
+			const float error{ abs(floatMap.GetInfluence(idx, layer) - fixedPointMap.GetInfluence(idx, layer)) };
+			errorSum += error;
+			maxError = max(maxError, error);
+			if (error > .05f)
+				++nrOfCellsOff;
+		}
+	}
+
+	// both buffers of every layer, all chunks are allocated once every tile ran
+	const double cellsInBuffers{ 2. * size * size * nrOfLayers };
+	const long long nrOfValues{ static_cast<long long>(size) * size * nrOfLayers };
+	printf("%dx%d grid, %d layers, every tile awake, %d ticks\n", size, size, nrOfLayers, nrOfTicks);
+	printf("  float  %7.2f ms/tick  %5.1f MB of influence\n", floatMs, cellsInBuffers * sizeof(Elite::FloatInfluence::Value) / (1024. * 1024.));
+	printf("  int16  %7.2f ms/tick  %5.1f MB of influence\n", fixedPointMs, cellsInBuffers * sizeof(Elite::FixedPointInfluence::Value) / (1024. * 1024.));
+	printf("  int16 against float: mean error %.4f, worst %.2f, %lld of %lld values off by more than 0.05\n",
+		errorSum / nrOfValues, maxError, nrOfCellsOff, nrOfValues);
+}
@@ -0,0 +1,45 @@
+#include "../stdafx.h"
+#include "Benchmarks.h"
+#include "../framework/EliteAI/EliteGraphs/EGridGraph.h"
+#include "../framework/EliteAI/EliteGraphs/EInfluenceMap.h"
+
+namespace
+{
+	using InfluenceGrid = Elite::GridGraph<Elite::WorldNode, Elite::GraphConnection>;
+}
+
+// Building and tearing down a 600x600 influence grid, with the nodes and connections coming out of the graph's pools.
+// Once with stored diagonal connections, once set up like the agent memory (row-major block, implicit connections)
+void Benchmarks::RunGraphPool()
+{
+	const int size{ 600 };
+	const int nrOfRounds{ 5 };
+
+	for (bool isLikeAgentMemory : { false, true })
+	{
+		double buildMs{ 0. }, teardownMs{ 0. };
+		int nrOfConnections{ 0 };
+		for (int round = 0; round < nrOfRounds; ++round)
+		{
+			Stopwatch stopwatch{};
+			Elite::InfluenceMap<InfluenceGrid>* pInfluenceMap{ new Elite::InfluenceMap<InfluenceGrid>(false) };
+			if (isLikeAgentMemory)
+			{
+				pInfluenceMap->SetNodeLayout(GridNodeLayout::RowMajor);
+				pInfluenceMap->SetUseImplicitConnections(true);
+			}
+			pInfluenceMap->InitializeGrid({ 0.f, 0.f }, size, size, 3, false, true);
+			pInfluenceMap->InitializeBuffer();
+			buildMs += stopwatch.GetElapsedMs();
+			nrOfConnections = pInfluenceMap->GetNrOfConnections();
+
+			stopwatch.Restart();
+			delete pInfluenceMap;
+			teardownMs += stopwatch.GetElapsedMs();
+		}
+
+		printf("%dx%d grid, %s, %d connections\n", size, size,
+			isLikeAgentMemory ? "row-major block, implicit connections" : "stored diagonal connections", nrOfConnections);
+		printf("  build %7.1f ms  teardown %7.1f ms\n", buildMs / nrOfRounds, teardownMs / nrOfRounds);
+	}
+}
@@ -0,0 +1,67 @@
+#include "../stdafx.h"
+#include "Benchmarks.h"
+#include "../framework/EliteAI/EliteGraphs/EGridGraph.h"
+#include "../framework/EliteAI/EliteGraphs/EInfluenceMap.h"
+
+namespace
+{
+	using InfluenceGrid = Elite::GridGraph<Elite::WorldNode, Elite::GraphConnection>;
+}
+
+// The SIMD row stencil against the connection walk over the same arrays (SetUseGridKernel(false)), on a full-grid tick.
+// Also times building the grid with stored connections, the way InitializeGrid did before implicit connections
+void Benchmarks::RunGridKernel()
+{
+	const int size{ 300 };
+	const int nrOfTicks{ 20 };
+
+	Stopwatch stopwatch{};
+	Elite::InfluenceMap<InfluenceGrid> kernelMap{ false };
+	kernelMap.InitializeGrid({ 0.f, 0.f }, size, size, 3, false, true);
+	kernelMap.InitializeBuffer();
+	const double buildMs{ stopwatch.GetElapsedMs() };
+
+	Elite::InfluenceMap<InfluenceGrid> walkMap{ false };
+	walkMap.InitializeGrid({ 0.f, 0.f }, size, size, 3, false, true);
+	walkMap.InitializeBuffer();
+	walkMap.SetUseGridKernel(false);
+
+	std::mt19937 random{ 1 };
+	std::uniform_int_distribution<int> cellDistribution{ 0, size * size - 1 };
+	std::uniform_real_distribution<float> influenceDistribution{ -100.f, 100.f };
+	for (Elite::InfluenceMap<InfluenceGrid>* pMap : { &kernelMap, &walkMap })
+	{
+		pMap->SetDecay(.2f);
+		pMap->SetMomentum(.3f);
+		pMap->SetChangeThreshold(0.f); // no tile goes to sleep, every tick is the whole grid
+	}
+	for (int i = 0; i < 200; ++i)
+	{
+		const int idx{ cellDistribution(random) };
+		const float influence{ influenceDistribution(random) };
+		kernelMap.SetInfluenceAtPosition(idx, influence);
+		walkMap.SetInfluenceAtPosition(idx, influence);
+	}
+
+	double kernelMs{ 0. }, walkMs{ 0. };
+	for (int tick = 0; tick < nrOfTicks; ++tick)
+	{
+		stopwatch.Restart();
+		kernelMap.PropagateInfluence(1.f);
+		kernelMs += stopwatch.GetElapsedMs();
+
+		stopwatch.Restart();
+		walkMap.PropagateInfluence(1.f);
+		walkMs += stopwatch.GetElapsedMs();
+	}
+
+	float maxDifference{ 0.f };
+	for (int idx = 0; idx < size * size; ++idx)
+		maxDifference = max(maxDifference, abs(kernelMap.GetInfluence(idx) - walkMap.GetInfluence(idx)));
+
+	printf("%dx%d grid, 8 neighbours, %d full-grid ticks\n", size, size, nrOfTicks);
+	printf("  building the grid with stored connections %8.1f ms\n", buildMs);
+	printf("  grid kernel                              %8.3f ms/tick%s\n", kernelMs / nrOfTicks, kernelMap.IsUsingGridKernel() ? "" : " (not used!)");
+	printf("  connection walk                          %8.3f ms/tick\n", walkMs / nrOfTicks);
+	printf("  largest difference between the two: %g\n", maxDifference);
+}
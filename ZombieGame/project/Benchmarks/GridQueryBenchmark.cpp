@@ -0,0 +1,63 @@
+#include "../stdafx.h"
+#include "Benchmarks.h"
+#include "../framework/EliteAI/EliteGraphs/EGridGraph.h"
+
+namespace
+{
+	using Grid = Elite::GridGraph<Elite::WorldNode, Elite::GraphConnection>;
+
+	// average per call over every centre, T_Query returns something to add up so the calls don't get optimized away
+	template <typename T_Query>
+	double TimeQuery(const std::vector<Elite::Vector2>& centres, long long& sink, T_Query query)
+	{
+		const int nrOfRounds{ 5 };
+		Benchmarks::Stopwatch stopwatch{};
+		for (int round = 0; round < nrOfRounds; ++round)
+		{
+			for (const Elite::Vector2& centre : centres)
+				sink += query(centre);
+		}
+		return stopwatch.GetElapsedUs() / (nrOfRounds * centres.size());
+	}
+}
+
+// The radius and rect queries of GridGraph: the unordered_set versions, the ones filling a caller-owned buffer and ForEachNodeInRadius
+void Benchmarks::RunGridQueries()
+{
+	const int size{ 300 };
+	const int cellSize{ 3 };
+	const float halfWorld{ size * cellSize / 2.f };
+
+	Grid grid{ false };
+	grid.InitializeGrid({ -halfWorld, -halfWorld }, size, size, cellSize, false, true);
+
+	std::mt19937 random{ 3 };
+	std::uniform_real_distribution<float> positionDistribution{ -halfWorld, halfWorld };
+	std::vector<Elite::Vector2> centres{};
+	for (int i = 0; i < 200; ++i)
+		centres.push_back({ positionDistribution(random), positionDistribution(random) });
+
+	std::vector<int> indices{};
+	long long sink{ 0 };
+	printf("%dx%d grid, cell size %d, %zu random centres, per call\n", size, size, cellSize, centres.size());
+	for (float radius : { 15.f, 60.f })
+	{
+		const double setUs{ TimeQuery(centres, sink, [&](const Elite::Vector2& centre) { return grid.GetNodeIndicesInRadius(centre, radius).size(); }) };
+		const double bufferUs{ TimeQuery(centres, sink, [&](const Elite::Vector2& centre) { grid.GetNodeIndicesInRadius(centre, radius, indices); return indices.size(); }) };
+		const double forEachUs{ TimeQuery(centres, sink, [&](const Elite::Vector2& centre)
+			{
+				long long idxSum{ 0 };
+				grid.ForEachNodeInRadius(centre, radius, [&idxSum](int idx) { idxSum += idx; });
+				return idxSum;
+			}) };
+		printf("  radius %3.0f:   set %7.2f us  buffer %6.2f us  ForEach %6.2f us\n", radius, setUs, bufferUs, forEachUs);
+	}
+
+	const Elite::Vector2 rectSize{ 30.f, 42.f };
+	const double setUs{ TimeQuery(centres, sink, [&](const Elite::Vector2& centre) { return grid.GetNodeIndicesInRect(centre, rectSize).size(); }) };
+	const double bufferUs{ TimeQuery(centres, sink, [&](const Elite::Vector2& centre) { grid.GetNodeIndicesInRect(centre, rectSize, indices); return indices.size(); }) };
+	printf("  rect %2.0fx%2.0f:   set %7.2f us  buffer %6.2f us\n", rectSize.x, rectSize.y, setUs, bufferUs);
+
+	if (sink == 42) // never, keeps the results alive
+		printf("\n");
+}
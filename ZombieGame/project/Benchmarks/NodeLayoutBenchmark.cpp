@@ -0,0 +1,155 @@
+#include "../stdafx.h"
+#include "Benchmarks.h"
+#include "../framework/EliteAI/EliteGraphs/EGridGraph.h"
+
+namespace
+{
+	using Grid = Elite::GridGraph<Elite::WorldNode, Elite::GraphConnection>;
+
+	// Set associative cache with LRU replacement and 64 byte lines, counts the misses of the addresses it's fed.
+	// Stands in for hardware counters, which aren't available everywhere the benchmark runs
+	class SimulatedCache
+	{
+	public:
+		SimulatedCache(int nrOfBytes, int nrOfWays)
+			: m_NrOfWays{ nrOfWays }
+			, m_Sets(nrOfBytes / m_LineSize / nrOfWays)
+		{
+		}
+
+		// true on a hit
+		bool Access(uintptr_t line)
+		{
+			std::vector<uintptr_t>& set{ m_Sets[line % m_Sets.size()] };
+			const auto it{ std::find(set.begin(), set.end(), line) };
+			const bool isHit{ it != set.end() };
+			if (isHit)
+				set.erase(it);
+			else
+				++m_NrOfMisses;
+
+			set.insert(set.begin(), line);
+			if (static_cast<int>(set.size()) > m_NrOfWays)
+				set.pop_back();
+			return isHit;
+		}
+
+		long long GetNrOfMisses() const { return m_NrOfMisses; }
+
+		static constexpr uintptr_t m_LineSize{ 64 };
+
+	private:
+		int m_NrOfWays;
+		std::vector<std::vector<uintptr_t>> m_Sets;
+		long long m_NrOfMisses{ 0 };
+	};
+}
+
+// The node layouts of GridGraph under the agent memory's access pattern: an agent walks over a 600x600 grid and reads the position
+// and scanned state of every node in a circle around it. Times the queries, and counts the misses of a 32KB/8-way L1 backed by
+// a 1MB/16-way L2 on the node addresses.
+void Benchmarks::RunNodeLayouts()
+{
+	const int size{ 600 };
+	const int cellSize{ 3 };
+	const float halfWorld{ size * cellSize / 2.f };
+
+	std::mt19937 random{ 7 };
+	std::uniform_real_distribution<float> angleDistribution{ 0.f, 6.28f };
+	std::vector<Elite::Vector2> walk{};
+	Elite::Vector2 position{ 0.f, 0.f }, velocity{ 1.f, 0.f };
+	for (int step = 0; step < 4000; ++step)
+	{
+		if (step % 200 == 0)
+		{
+			const float angle{ angleDistribution(random) };
+			velocity = { cosf(angle) * 1.5f, sinf(angle) * 1.5f };
+		}
+		position += velocity;
+		if (position.x < -800.f || position.x > 800.f)
+			velocity.x = -velocity.x;
+		if (position.y < -800.f || position.y > 800.f)
+			velocity.y = -velocity.y;
+		walk.push_back(position);
+	}
+
+	// heap churn first, the game allocates before the grid is built and the separate nodes land in between
+	std::vector<void*> allocations{};
+	std::uniform_int_distribution<int> allocationSizeDistribution{ 16, 216 };
+	for (int i = 0; i < 200000; ++i)
+		allocations.push_back(malloc(allocationSizeDistribution(random)));
+	for (size_t i = 0; i < allocations.size(); i += 2)
+	{
+		free(allocations[i]);
+		allocations[i] = nullptr;
+	}
+
+	printf("%dx%d grid, %zu steps, sizeof(WorldNode) %zu, misses per query\n", size, size, walk.size(), sizeof(Elite::WorldNode));
+	const std::pair<GridNodeLayout, const char*> layouts[]
+	{
+		{ GridNodeLayout::Separate, "Separate" },
+		{ GridNodeLayout::RowMajor, "RowMajor" },
+		{ GridNodeLayout::Morton, "Morton" },
+	};
+	double sink{ 0. };
+	for (const auto& layout : layouts)
+	{
+		Grid grid{ false };
+		grid.SetUseImplicitConnections(true);
+		grid.SetNodeLayout(layout.first);
+		grid.InitializeGrid({ -halfWorld, -halfWorld }, size, size, cellSize, false, true);
+
+		for (float radius : { 60.f, 120.f })
+		{
+			const int nrOfRounds{ 3 };
+			Stopwatch stopwatch{};
+			for (int round = 0; round < nrOfRounds; ++round)
+			{
+				for (const Elite::Vector2& centre : walk)
+				{
+					grid.ForEachNodeInRadius(centre, radius, [&](int idx)
+						{
+							const Elite::WorldNode* pNode{ grid.GetNode(idx) };
+							sink += pNode->GetPosition().x + (pNode->GetScanned() ? 1.f : 0.f);
+						});
+				}
+			}
+			const double queryUs{ stopwatch.GetElapsedUs() / (nrOfRounds * walk.size()) };
+
+			SimulatedCache l1{ 32 * 1024, 8 }, l2{ 1024 * 1024, 16 };
+			for (const Elite::Vector2& centre : walk)
+			{
+				grid.ForEachNodeInRadius(centre, radius, [&](int idx)
+					{
+						const uintptr_t address{ reinterpret_cast<uintptr_t>(grid.GetNode(idx)) };
+						for (uintptr_t line = address / SimulatedCache::m_LineSize; line <= (address + sizeof(Elite::WorldNode) - 1) / SimulatedCache::m_LineSize; ++line)
+						{
+							if (!l1.Access(line))
+								l2.Access(line);
+						}
+					});
+			}
+			printf("  %-8s r=%3.0f  %7.2f us/query  L1 %7.1f  L2 %6.1f\n", layout.second, radius, queryUs,
+				double(l1.GetNrOfMisses()) / walk.size(), double(l2.GetNrOfMisses()) / walk.size());
+		}
+
+		const int nrOfRounds{ 10 };
+		Stopwatch stopwatch{};
+		for (int round = 0; round < nrOfRounds; ++round)
+		{
+			for (int idx = 0; idx < size * size; ++idx)
+			{
+				Elite::WorldNode* pNode{ grid.GetNode(idx) };
+				pNode->SetScanned(!pNode->GetScanned());
+				sink += pNode->GetIndex();
+			}
+		}
+		printf("  %-8s full index walk %.2f ms\n", layout.second, stopwatch.GetElapsedMs() / nrOfRounds);
+	}
+
+	for (void* pAllocation : allocations)
+		free(pAllocation);
+
+	if (sink == 42.) // never, keeps the reads alive
+		printf("\n");
+}
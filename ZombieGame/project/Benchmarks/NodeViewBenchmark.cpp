@@ -0,0 +1,64 @@
+#include "../stdafx.h"
+#include "Benchmarks.h"
+#include "../framework/EliteAI/EliteGraphs/EGridGraph.h"
+
+namespace
+{
+	using Grid = Elite::GridGraph<Elite::WorldNode, Elite::GraphConnection>;
+}
+
+// Walking the nodes of a 200x200 grid once a frame: GetAllNodes copies them into a vector, GetActiveNodes and GetNodes(indices)
+// are views over the node storage. One node is removed, so the views have something to skip
+void Benchmarks::RunNodeViews()
+{
+	const int size{ 200 };
+	const int nrOfFrames{ 100 };
+
+	Grid grid{ false };
+	grid.SetUseImplicitConnections(true);
+	grid.InitializeGrid({ 0.f, 0.f }, size, size, 2, false, true);
+	grid.RemoveNode(5);
+
+	std::unordered_set<int> area{};
+	for (int i = 0; i < 400; ++i)
+		area.insert(i * 7);
+
+	long long idxSum{ 0 };
+	long long nrOfAllocations{ GetNrOfAllocations() };
+	Stopwatch stopwatch{};
+	for (int frame = 0; frame < nrOfFrames; ++frame)
+	{
+		for (const Elite::WorldNode* pNode : grid.GetAllNodes())
+			idxSum += pNode->GetIndex();
+	}
+	const double allNodesUs{ stopwatch.GetElapsedUs() / nrOfFrames };
+	const long long allNodesAllocations{ GetNrOfAllocations() - nrOfAllocations };
+
+	nrOfAllocations = GetNrOfAllocations();
+	stopwatch.Restart();
+	for (int frame = 0; frame < nrOfFrames; ++frame)
+	{
+		for (const Elite::WorldNode* pNode : grid.GetActiveNodes())
+			idxSum += pNode->GetIndex();
+	}
+	const double activeNodesUs{ stopwatch.GetElapsedUs() / nrOfFrames };
+	const long long activeNodesAllocations{ GetNrOfAllocations() - nrOfAllocations };
+
+	nrOfAllocations = GetNrOfAllocations();
+	stopwatch.Restart();
+	for (int frame = 0; frame < nrOfFrames; ++frame)
+	{
+		for (const Elite::WorldNode* pNode : grid.GetNodes(area))
+			idxSum += pNode->GetIndex();
+	}
+	const double areaNodesUs{ stopwatch.GetElapsedUs() / nrOfFrames };
+	const long long areaNodesAllocations{ GetNrOfAllocations() - nrOfAllocations };
+
+	printf("%dx%d grid, one node removed, per frame\n", size, size);
+	printf("  GetAllNodes             %7.1f us  %lld allocations\n", allNodesUs, allNodesAllocations / nrOfFrames);
+	printf("  GetActiveNodes          %7.1f us  %lld allocations\n", activeNodesUs, activeNodesAllocations / nrOfFrames);
+	printf("  GetNodes(%zu indices)  %7.1f us  %lld allocations\n", area.size(), areaNodesUs, areaNodesAllocations / nrOfFrames);
+
+	if (idxSum == 42) // never, keeps the walks alive
+		printf("\n");
+}
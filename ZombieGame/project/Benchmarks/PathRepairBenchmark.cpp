@@ -0,0 +1,175 @@
+#include "../stdafx.h"
+#include "Benchmarks.h"
+#include "../framework/EliteAI/EliteGraphs/EInfluenceMap.h"
+#include "../framework/EliteAI/EliteGraphs/EliteGraphAlgorithms/EDStarLite.h"
+
+namespace
+{
+	using InfluenceGrid = Elite::GridGraph<Elite::WorldNode, Elite::GraphConnection>;
+	using Planner = Elite::DStarLite<Elite::WorldNode, Elite::GraphConnection>;
+
+	struct Zombie
+	{
+		float col, row;
+		float velocityCol, velocityRow;
+	};
+
+	void RunPathRepairScenario(float propagationRadius)
+	{
+		const int size{ 400 };
+		const int nrOfZombies{ 40 };
+		const int nrOfZones{ 60 };
+		const int nrOfTicks{ 200 };
+		const float changeThreshold{ .5f }; // the agent memory's
+		Elite::InfluenceMap<InfluenceGrid>::PathSettings settings{};
+
+		Elite::InfluenceMap<InfluenceGrid> influenceMap{ false };
+		influenceMap.SetUseImplicitConnections(true);
+		influenceMap.SetNodeLayout(GridNodeLayout::RowMajor);
+		influenceMap.InitializeGrid({ 0.f, 0.f }, size, size, 5, false, true);
+		influenceMap.InitializeBuffer();
+		influenceMap.SetMomentum(.3f);
+		influenceMap.SetDecay(.2f);
+		influenceMap.WatchChanges(settings.layer, changeThreshold);
+
+		const auto watchedCost = [&](int toIdx, float connectionCost)
+		{
+			return connectionCost * (1.f + settings.dangerPenalty * max(-influenceMap.GetWatchedInfluence(toIdx), 0.f));
+		};
+		const auto pathCost = [&](const std::vector<int>& path)
+		{
+			float cost{ 0.f };
+			for (size_t i = 1; i < path.size(); ++i)
+			{
+				const bool isDiagonal{ path[i] % size != path[i - 1] % size && path[i] / size != path[i - 1] / size };
+				cost += (isDiagonal ? 1.5f : 1.f) * (1.f + settings.dangerPenalty * max(-influenceMap.GetInfluence(path[i], settings.layer), 0.f));
+			}
+			return cost;
+		};
+
+		std::mt19937 random{ 7 };
+		std::uniform_int_distribution<int> cellDistribution{ 0, size - 1 };
+		std::uniform_real_distribution<float> velocityDistribution{ -1.f, 1.f };
+
+		for (int zone = 0; zone < nrOfZones; ++zone)
+		{
+			const int col{ cellDistribution(random) }, row{ cellDistribution(random) };
+			const int radius{ 5 + cellDistribution(random) % 15 };
+			for (int r = row - radius; r <= row + radius; ++r)
+			{
+				for (int c = col - radius; c <= col + radius; ++c)
+				{
+					if ((r - row) * (r - row) + (c - col) * (c - col) <= radius * radius && influenceMap.IsWithinBounds(c, r))
+						influenceMap.SetInfluenceAtPosition(influenceMap.GetIndex(c, r), -40.f, settings.layer);
+				}
+			}
+		}
+
+		std::vector<Zombie> zombies{};
+		for (int i = 0; i < nrOfZombies; ++i)
+			zombies.push_back({ float(cellDistribution(random)), float(cellDistribution(random)), velocityDistribution(random), velocityDistribution(random) });
+
+		Planner planner{ &influenceMap, Elite::HeuristicFunctions::GridOctile, watchedCost };
+		std::vector<int> changedCells{}, repairedPath{}, scratchPath{}, safePath{};
+		influenceMap.TakeChangedCells(changedCells);
+
+		int startIdx{ influenceMap.GetIndex(5, 5) };
+		const int goalIdx{ influenceMap.GetIndex(size - 6, size - 6) };
+		double firstSearchUs{ 0. }, repairUs{ 0. }, scratchUs{ 0. }, safePathUs{ 0. };
+		long long repairExpansions{ 0 }, scratchExpansions{ 0 };
+		size_t nrOfChangedCells{ 0 };
+		double costRatioSum{ 0. }, worstCostRatio{ 1. };
+		int nrOfRepairs{ 0 }, nrOfComparedPaths{ 0 }, nrOfReachabilityMismatches{ 0 };
+
+		for (int tick = 0; tick < nrOfTicks && startIdx != goalIdx; ++tick)
+		{
+			for (Zombie& zombie : zombies)
+			{
+				zombie.col += zombie.velocityCol;
+				zombie.row += zombie.velocityRow;
+				if (zombie.col < 0.f || zombie.col >= size)
+				{
+					zombie.velocityCol = -zombie.velocityCol;
+					zombie.col += 2.f * zombie.velocityCol;
+				}
+				if (zombie.row < 0.f || zombie.row >= size)
+				{
+					zombie.velocityRow = -zombie.velocityRow;
+					zombie.row += 2.f * zombie.velocityRow;
+				}
+				influenceMap.SetInfluenceAtPosition(influenceMap.GetIndex(int(zombie.col), int(zombie.row)), -100.f, settings.layer);
+			}
+			if (propagationRadius > 0.f)
+				influenceMap.PropagateInfluence(.05f, influenceMap.GetNodeWorldPos(startIdx), propagationRadius);
+			else
+				influenceMap.PropagateInfluence(.05f);
+			influenceMap.TakeChangedCells(changedCells);
+			nrOfChangedCells += changedCells.size();
+
+			Benchmarks::Stopwatch stopwatch{};
+			planner.OnCellsChanged(changedCells);
+			const bool isRepairedReachable{ planner.FindPath(startIdx, goalIdx, repairedPath) };
+			const double elapsedUs{ stopwatch.GetElapsedUs() };
+
+			// the first query is a search from scratch as well
+			if (tick == 0)
+			{
+				firstSearchUs = elapsedUs;
+			}
+			else
+			{
+				repairUs += elapsedUs;
+				repairExpansions += planner.GetNrOfExpansions();
+
+				Planner scratchPlanner{ &influenceMap, Elite::HeuristicFunctions::GridOctile, watchedCost };
+				stopwatch.Restart();
+				scratchPlanner.FindPath(startIdx, goalIdx, scratchPath);
+				scratchUs += stopwatch.GetElapsedUs();
+				scratchExpansions += scratchPlanner.GetNrOfExpansions();
+
+				stopwatch.Restart();
+				const bool isSafeReachable{ influenceMap.FindSafePath(startIdx, goalIdx, settings, safePath) };
+				safePathUs += stopwatch.GetElapsedUs();
+
+				if (isRepairedReachable != isSafeReachable)
+					++nrOfReachabilityMismatches;
+				else if (isRepairedReachable)
+				{
+					const double costRatio{ pathCost(repairedPath) / pathCost(safePath) };
+					costRatioSum += costRatio;
+					worstCostRatio = max(worstCostRatio, costRatio);
+					++nrOfComparedPaths;
+				}
+				++nrOfRepairs;
+			}
+
+			startIdx = repairedPath.size() > 2 ? repairedPath[2] : goalIdx;
+		}
+
+		if (nrOfRepairs == 0)
+			return;
+
+		printf("%dx%d grid, %d zombies, %d zones, change threshold %.2f, %d replans, %.0f changed cells a tick\n",
+			size, size, nrOfZombies, nrOfZones, changeThreshold, nrOfRepairs, double(nrOfChangedCells) / (nrOfRepairs + 1));
+		if (propagationRadius > 0.f)
+			printf("  propagating %.0f around the agent\n", propagationRadius);
+		else
+			printf("  propagating the whole map\n");
+		printf("  D* Lite first search     %8.0f us\n", firstSearchUs);
+		printf("  D* Lite repair           %8.0f us  %8lld expansions\n", repairUs / nrOfRepairs, repairExpansions / nrOfRepairs);
+		printf("  D* Lite from scratch     %8.0f us  %8lld expansions\n", scratchUs / nrOfRepairs, scratchExpansions / nrOfRepairs);
+		printf("  FindSafePath (A*)        %8.0f us\n", safePathUs / nrOfRepairs);
+		printf("  repaired path cost / A* path cost: %.5f on average, %.5f at worst, reachability differed %d times\n",
+			costRatioSum / max(nrOfComparedPaths, 1), worstCostRatio, nrOfReachabilityMismatches);
+	}
+}
+
+// FollowPath's planner against a search from scratch on every replan, on a map whose danger keeps moving.
+// Zombies wander over a 400x400 influence grid next to a few static danger zones, the agent walks two cells towards the far
+// corner every tick and replans. The repair hears about the cells the change list reported, like FollowPath does.
+// The agent memory only propagates around the agent, the whole map changes a lot more cells a tick
+void Benchmarks::RunPathRepair()
+{
+	RunPathRepairScenario(100.f); // 20 cells
+	RunPathRepairScenario(0.f);
+}
@@ -2,6 +2,19 @@
 #include "Exam_HelperStructs.h"
 #include <functional>
 
+// Layers of the agent's influence map, plain enum so they can be passed as the layer index
+namespace InfluenceLayer
+{
+	enum : int
+	{
+		DANGER,			// purge zones and bites, negative
+		REWARD,			// houses that still need clearing, positive
+		EXPLORATION,	// where the agent has been recently, negative
+		LOOT,			// located items, positive
+		COUNT
+	};
+}
+
 struct EAgentInfo : AgentInfo
 {
 	EAgentInfo(const AgentInfo& info) : AgentInfo(info) {}
@@ -15,10 +15,20 @@ SurvivorAgentMemory::SurvivorAgentMemory(IExamInterface* pInterface)
 	int celSize{ static_cast<int>(pInterface->Agent_GetInfo().GrabRange * 1.5f) };
 	int colRows{ static_cast<int>(worldDimension) / celSize };
 
+	m_pInfluenceMap->SetNrOfLayers(InfluenceLayer::COUNT);
+	m_pInfluenceMap->SetUseImplicitConnections(true); // a plain grid, no need to store every connection
+	m_pInfluenceMap->SetNodeLayout(GridNodeLayout::RowMajor); // one block, the colors are copied over in index order every render
 	m_pInfluenceMap->InitializeGrid({ -worldDimension / 2.f, -worldDimension / 2.f }, colRows, colRows, celSize, false, true);
 	m_pInfluenceMap->InitializeBuffer();
 	m_pInfluenceMap->SetMomentum(.3f);
 	m_pInfluenceMap->SetDecay(.2f);
+	m_pInfluenceMap->SetDecay(InfluenceLayer::EXPLORATION, .5f); // stays close to the path the agent walked, NavigateInfluence keeps off it
+	m_pInfluenceMap->SetMomentum(InfluenceLayer::LOOT, .6f); // items don't move, keep them around longer
+	m_pInfluenceMap->SetNrOfPropagationThreads(m_NrOfPropagationThreads);
+	m_pInfluenceMap->SetPropagationBudget(m_PropagationBudget);
+	m_pInfluenceMap->WatchChanges(InfluenceLayer::DANGER, m_DangerChangeThreshold); // FollowPath repairs its path with these cells
+	m_RegionChangeList = m_pInfluenceMap->AddChangeList(); // list 0 stays with FollowPath
+	m_pRegions = new Elite::GridRegions<Elite::WorldNode, Elite::GraphConnection>(m_pInfluenceMap);
 
 	m_pGraphRenderer = new Elite::GraphRenderer();
 }
@@ -30,6 +40,9 @@ SurvivorAgentMemory::~SurvivorAgentMemory()
 
 	delete m_pGraphRenderer;
 	m_pGraphRenderer = nullptr;
+
+	delete m_pRegions;
+	m_pRegions = nullptr;
 }
 
 void SurvivorAgentMemory::Update(float deltaTime, IExamInterface* pInterface, std::vector<EntityInfo*> entitiesInFOV, std::vector<HouseInfo*> housesInFOV)
@@ -42,33 +55,60 @@ void SurvivorAgentMemory::Update(float deltaTime, IExamInterface* pInterface, st
 void SurvivorAgentMemory::UpdateInfluenceMap(float deltaTime, IExamInterface* pInterface)
 {
 	m_pInfluenceMap->PropagateInfluence(deltaTime, pInterface->Agent_GetInfo().Location, m_PropagationRadius);
+
+	// Only the cells whose danger moved past the change threshold come back, of those only the ones crossing m_BlockingDanger touch the regions.
+	// They're compared with the reported danger, so a cell drifting slowly over the line still flips once it's reported
+	m_pInfluenceMap->TakeChangedCells(m_ChangedDangerCells, m_RegionChangeList);
+	for (int idx : m_ChangedDangerCells)
+		m_pRegions->SetPassable(idx, m_pInfluenceMap->GetWatchedInfluence(idx) > m_BlockingDanger);
+}
+
+// Whether the agent can get to the cell without crossing danger.
+// Also true while the agent stands in danger itself, every way out crosses it then
+bool SurvivorAgentMemory::IsReachable(int idx) const
+{
+	const int agentIdx{ m_pInfluenceMap->GetNodeIdxAtWorldPos(m_pInterface->Agent_GetInfo().Location) };
+	if (m_pRegions->GetRegion(agentIdx) == invalid_node_index)
+		return true;
+
+	return m_pRegions->IsSameRegion(agentIdx, idx);
 }
 
 // Get indices of the cells in the house area
 std::unordered_set<int> SurvivorAgentMemory::GetHouseArea(const HouseInfo& house)
 {
-	return m_pInfluenceMap->GetNodeIndicesInRect(house.Center, { house.Size.x - m_pInfluenceMap->GetCellSize(), house.Size.y - m_pInfluenceMap->GetCellSize()});
+	return m_pInfluenceMap->GetNodeIndicesInRect(house.Center, GetHouseAreaSize(house));
+}
+
+// Size of the rect the house area covers, leaves out the cells of the walls
+Elite::Vector2 SurvivorAgentMemory::GetHouseAreaSize(const HouseInfo& house) const
+{
+	return { house.Size.x - m_pInfluenceMap->GetCellSize(), house.Size.y - m_pInfluenceMap->GetCellSize() };
+}
+
+// Same as IsAreaExplored(GetHouseArea(house)), but counts the scanned bits of the house rect instead of visiting every cell
+bool SurvivorAgentMemory::IsHouseAreaExplored(const HouseInfo& house) const
+{
+	return m_pInfluenceMap->GetScannedRatioInRect(house.Center, GetHouseAreaSize(house)) >= m_PercentageToClear;
 }
 
-void SurvivorAgentMemory::ForgetArea(std::unordered_set<int> area)
+void SurvivorAgentMemory::ForgetArea(const std::unordered_set<int>& area)
 {
 	// Reset all the given nodes' scanned status
-	for (const auto& idx : area)
-	{
-		m_pInfluenceMap->GetNode(idx)->SetScanned(false);
-	}
+	m_pInfluenceMap->SetScannedAtPosition(area, false);
 }
 
 bool SurvivorAgentMemory::OnPickUpItem(const ItemInfo& item)
 {
 	// Make sure we're picking up the correct node since we're only saving 1 item per node right now
-	auto node{ m_pInfluenceMap->GetNodeAtWorldPos(item.Location) };
-	if (node->GetItem() != item.Type)
+	const int nodeIdx{ m_pInfluenceMap->GetNodeIdxAtWorldPos(item.Location) };
+	if (!m_pInfluenceMap->IsNodeValid(nodeIdx) || m_pInfluenceMap->GetItemType(nodeIdx) != item.Type)
 		return false;
 
 	// Remove item from node
-	node->RemoveItem();
-	m_LocatedItems.erase(node->GetIndex());
+	m_pInfluenceMap->RemoveItem(nodeIdx);
+	m_pInfluenceMap->SetInfluenceAtPosition(nodeIdx, 0.f, InfluenceLayer::LOOT);
+	m_LocatedItems.erase(nodeIdx);
 	return true;
 }
 
@@ -82,24 +122,30 @@ bool SurvivorAgentMemory::OnPickUpItem(const EntityInfo& entity)
 		return false;
 
 	// If item type on node is not the one picked up, return false;
-	auto node{ m_pInfluenceMap->GetNodeAtWorldPos(entity.Location) };
-	if (node->GetItem() != item.Type)
+	const int nodeIdx{ m_pInfluenceMap->GetNodeIdxAtWorldPos(entity.Location) };
+	if (!m_pInfluenceMap->IsNodeValid(nodeIdx) || m_pInfluenceMap->GetItemType(nodeIdx) != item.Type)
 		return false;
 
 	// Remove from located items
-	node->RemoveItem();
-	m_LocatedItems.erase(node->GetIndex());
+	m_pInfluenceMap->RemoveItem(nodeIdx);
+	m_pInfluenceMap->SetInfluenceAtPosition(nodeIdx, 0.f, InfluenceLayer::LOOT);
+	m_LocatedItems.erase(nodeIdx);
 	return true;
 }
 
 void SurvivorAgentMemory::LocateHouse(const HouseInfo& houseInfo)
+{
+	LocateHouse(houseInfo, m_pInfluenceMap->GetNodeIdxAtWorldPos(houseInfo.Center));
+}
+
+// Same, with the node of the house center already looked up
+void SurvivorAgentMemory::LocateHouse(const HouseInfo& houseInfo, int houseNodeIdx)
 {
 	// Check if house already seen
-	const auto houseNode{ m_pInfluenceMap->GetNodeAtWorldPos(houseInfo.Center) };
-	if (m_LocatedHouses.find(houseNode->GetIndex()) == m_LocatedHouses.end()) 
+	if (m_pInfluenceMap->IsNodeValid(houseNodeIdx) && m_LocatedHouses.find(houseNodeIdx) == m_LocatedHouses.end())
 	{
 		// If not seen save it
-		m_LocatedHouses[houseNode->GetIndex()] = houseInfo;
+		m_LocatedHouses[houseNodeIdx] = houseInfo;
 	}
 }
 
@@ -107,16 +153,17 @@ void SurvivorAgentMemory::LocateHouse(const HouseInfo& houseInfo)
 // Also updates if house already located
 bool SurvivorAgentMemory::IsHouseCleared(const HouseInfo& houseInfo)
 {
-	const auto houseNodeIdx{ m_pInfluenceMap->GetNodeIdxAtWorldPos(houseInfo.Center) };
+	return IsHouseCleared(houseInfo, m_pInfluenceMap->GetNodeIdxAtWorldPos(houseInfo.Center));
+}
 
+// Same, with the node of the house center already looked up
+bool SurvivorAgentMemory::IsHouseCleared(const HouseInfo& houseInfo, int houseNodeIdx)
+{
 	// Check if the house has been marked as cleared before
 	if (m_LocatedHouses.count(houseNodeIdx) && m_LocatedHouses[houseNodeIdx].Cleared)
 		return true;
 
-	// Get node indices in house area
-	const auto area{ GetHouseArea(houseInfo) };
-
-	return IsAreaExplored(area);
+	return IsHouseAreaExplored(houseInfo);
 }
 
 // Checks if given house is cleared, if it is, pass its area, otherwise pass nothing
@@ -137,7 +184,7 @@ bool SurvivorAgentMemory::IsHouseCleared(const HouseInfo& houseInfo, std::unorde
 	// Pass house area
 	area = houseArea;
 
-	bool isExplored{ IsAreaExplored(area) };
+	bool isExplored{ IsHouseAreaExplored(houseInfo) };
 	m_LocatedHouses[houseNodeIdx].Cleared = isExplored;
 
 	return isExplored;
@@ -169,34 +216,50 @@ bool SurvivorAgentMemory::IsHouseCleared(std::unordered_set<int>& unscannedArea,
 // Locate houses and update their cleared status
 void SurvivorAgentMemory::UpdateHouses(float deltaTime, IExamInterface* pInterface, const std::vector<HouseInfo*>& housesInFOV)
 {
-	// Locate all houses in sight
+	// Look up the nodes of all house centers in sight at once
+	m_SeenPositions.clear();
 	for (const auto& house : housesInFOV)
+		m_SeenPositions.push_back(house->Center);
+	m_pInfluenceMap->GetNodeIndicesAtWorldPos(m_SeenPositions, m_SeenNodes);
+
+	// Locate all houses in sight, the ones that still need clearing attract the agent
+	for (size_t i = 0; i < housesInFOV.size(); ++i)
 	{
-		LocateHouse(*house);
+		const int houseNodeIdx{ m_SeenNodes[i] };
+		if (!m_pInfluenceMap->IsNodeValid(houseNodeIdx))
+			continue;
+
+		LocateHouse(*housesInFOV[i], houseNodeIdx);
+		if (!IsHouseCleared(*housesInFOV[i], houseNodeIdx))
+			m_pInfluenceMap->SetInfluenceAtPosition(houseNodeIdx, 50, InfluenceLayer::REWARD);
 	}
 
+	// The located houses are keyed on the node of their center
 	for (auto& house : m_LocatedHouses)
 	{
 		// Reset areas to unexplored after a certain time so the agent continues going house to house
 		if (house.second.UpdateResetTime(deltaTime))
 		{
-			ForgetArea(GetHouseArea(house.second));
+			m_pInfluenceMap->SetScannedInRect(house.second.Center, GetHouseAreaSize(house.second), false);
 		}
 
 		// Save cleared status
-		if (IsHouseCleared(house.second))
+		if (IsHouseCleared(house.second, house.first))
 		{
 			house.second.Cleared = true;
 		}
 	}
 }
 
-// Locate item
-void SurvivorAgentMemory::LocateItem(const ItemInfo& item)
+// Locate item on the node of its location
+void SurvivorAgentMemory::LocateItem(const ItemInfo& item, int nodeIdx)
 {
-	auto node{ m_pInfluenceMap->GetNodeAtWorldPos(item.Location) };
-	node->SetItem(item);
-	m_LocatedItems.insert(node->GetIndex());
+	if (!m_pInfluenceMap->IsNodeValid(nodeIdx))
+		return;
+
+	m_pInfluenceMap->SetItem(nodeIdx, item);
+	m_pInfluenceMap->SetInfluenceAtPosition(nodeIdx, 50, InfluenceLayer::LOOT);
+	m_LocatedItems.insert(nodeIdx);
 }
 
 void SurvivorAgentMemory::UpdateEntities(IExamInterface* pInterface, std::vector<EntityInfo*> entitiesInFOV) 
@@ -204,24 +267,24 @@ void SurvivorAgentMemory::UpdateEntities(IExamInterface* pInterface, std::vector
 	EAgentInfo eAgentInfo = pInterface->Agent_GetInfo();
 	const Elite::Vector2 scanPos{ eAgentInfo.Location + (eAgentInfo.GetForward() * eAgentInfo.FOV_Range / 2.0f) };
 	const float scanRadius{ eAgentInfo.FOV_Range / 2.0f };
-	const auto& indices{ m_pInfluenceMap->GetNodeIndicesInRadius(scanPos, scanRadius) };
-
 
 	// Mark cell that agent finds himself in as seen
-	m_pInfluenceMap->SetScannedAtPosition(m_pInfluenceMap->GetNodeAtWorldPos(eAgentInfo.Location)->GetIndex(), true);
-	// Mark the cells in his FOV as seen
-	m_pInfluenceMap->SetScannedAtPosition(indices, true);
-
+	m_pInfluenceMap->SetScannedAtPosition(m_pInfluenceMap->GetNodeIdxAtWorldPos(eAgentInfo.Location), true);
+	m_pInfluenceMap->SetInfluenceAtPosition(eAgentInfo.Location, -25, InfluenceLayer::EXPLORATION);
+	// Mark the cells in his FOV cone as seen, with enough rays that neighbouring ones stay a cell apart at the far end
+	const int nrOfScanRays{ static_cast<int>(eAgentInfo.FOV_Angle * eAgentInfo.FOV_Range / m_pInfluenceMap->GetCellSize()) + 2 };
+	m_pInfluenceMap->RayMarchCone(eAgentInfo.Location, eAgentInfo.GetForward(), eAgentInfo.FOV_Angle, eAgentInfo.FOV_Range, nrOfScanRays,
+		[this](int idx) { m_pInfluenceMap->SetScannedAtPosition(idx, true); return false; });
+
+	m_SeenItems.clear();
 	for (const auto& e : entitiesInFOV)
 	{
-		// Locate items in sight
+		// Gather the items in sight, they're located together below
 		if (e->Type == eEntityType::ITEM)
 		{
 			ItemInfo info{  };
-			if (!pInterface->Item_GetInfo(*e, info))
-				return;
-
-			LocateItem(info);
+			if (pInterface->Item_GetInfo(*e, info))
+				m_SeenItems.push_back(info);
 		}
 
 		// Watch for danger from purge zones
@@ -234,37 +297,45 @@ void SurvivorAgentMemory::UpdateEntities(IExamInterface* pInterface, std::vector
 				// If FOV overlaps with purgezone
 				if (Elite::IsCirclesOverlapping(scanPos, purgeZone.Center, scanRadius, purgeZone.Radius))
 				{
-					m_pInfluenceMap->SetInfluenceAtPosition(scanPos, -50); // Set Danger
+					m_pInfluenceMap->SetInfluenceAtPosition(scanPos, -50, InfluenceLayer::DANGER); // Set Danger
 				}
 			}
 		}
 	}
 
-	if (eAgentInfo.WasBitten) m_pInfluenceMap->SetInfluenceAtPosition(eAgentInfo.Location, -100);
+	// Locate items in sight, their nodes looked up in one batch
+	m_SeenPositions.clear();
+	for (const auto& item : m_SeenItems)
+		m_SeenPositions.push_back(item.Location);
+	m_pInfluenceMap->GetNodeIndicesAtWorldPos(m_SeenPositions, m_SeenNodes);
+
+	for (size_t i = 0; i < m_SeenItems.size(); ++i)
+		LocateItem(m_SeenItems[i], m_SeenNodes[i]);
+
+	if (eAgentInfo.WasBitten) m_pInfluenceMap->SetInfluenceAtPosition(eAgentInfo.Location, -100, InfluenceLayer::DANGER);
 }
 
-bool SurvivorAgentMemory::IsAreaExplored(std::unordered_set<int> area) const
+bool SurvivorAgentMemory::IsAreaExplored(const std::unordered_set<int>& area) const
 {
 	int nrCellsCleared{ 0 };
 	for (int i : area)
 	{
-		if (m_pInfluenceMap->GetNode(i)->GetScanned())
+		if (m_pInfluenceMap->IsScanned(i))
 			++nrCellsCleared;
 	}
 
 	return static_cast<float>(nrCellsCleared) / static_cast<float>(area.size()) >= m_PercentageToClear;
 }
 
-bool SurvivorAgentMemory::IsAreaExplored(std::unordered_set<int> area, std::unordered_set<int>& unscannedArea) const
+bool SurvivorAgentMemory::IsAreaExplored(const std::unordered_set<int>& area, std::unordered_set<int>& unscannedArea) const
 {
 	int nrCellsCleared{ 0 };
 	for (int i : area)
 	{
-		if (m_pInfluenceMap->GetNode(i)->GetScanned())
-		{
+		if (m_pInfluenceMap->IsScanned(i))
 			++nrCellsCleared;
+		else
 			unscannedArea.insert(i);
-		}
 	}
 
 	return static_cast<float>(nrCellsCleared) / static_cast<float>(area.size()) >= m_PercentageToClear;
@@ -289,6 +360,6 @@ void SurvivorAgentMemory::RenderInfluenceMap(IExamInterface* pInterface) const
 		house.second.Cleared ? color = { 0,1,0 } : color = { 1,0,0 };
 		pInterface->Draw_Circle(house.second.Center, min(house.second.Size.x, house.second.Size.y), color);
 	}
-	auto visibleNodes{ m_pInfluenceMap->GetNodeIndicesInRadius(pInterface->Agent_GetInfo().Location, m_PropagationRadius) };
-	m_pGraphRenderer->RenderNodes(m_pInfluenceMap, pInterface, visibleNodes, true, false, false, false);
+	m_pInfluenceMap->GetNodeIndicesInRadius(pInterface->Agent_GetInfo().Location, m_PropagationRadius, m_VisibleNodes);
+	m_pGraphRenderer->RenderNodes(m_pInfluenceMap, pInterface, m_VisibleNodes, true, false, false, false);
 }
\ No newline at end of file
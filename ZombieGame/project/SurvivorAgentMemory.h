@@ -4,6 +4,7 @@
 #include "framework\EliteAI\EliteGraphs\EInfluenceMap.h"
 #include "framework\EliteAI\EliteGraphs\EGraph2D.h"
 #include "framework\EliteAI\EliteGraphs\EGridGraph.h"
+#include "framework\EliteAI\EliteGraphs\EliteGraphAlgorithms\EGridRegions.h"
 
 class IExamInterface;
 
@@ -21,12 +22,13 @@ public:
 	void RenderInfluenceMap(IExamInterface* pInterface) const;
 
 	bool HasSeenItems() const { return !m_LocatedItems.empty(); };
+	bool IsReachable(int idx) const;
 
 	Elite::InfluenceMap<InfluenceGrid>* GetInfluenceMap() const { return m_pInfluenceMap; };
 	std::unordered_set<int> GetLocatedItems() const { return m_LocatedItems; };
 	std::unordered_map<int, EHouseInfo> GetLocatedHouses() const { return m_LocatedHouses; };
 	std::unordered_set<int> GetHouseArea(const HouseInfo& house);
-	void ForgetArea(std::unordered_set<int> area);
+	void ForgetArea(const std::unordered_set<int>& area);
 	bool OnPickUpItem(const ItemInfo& item);
 	bool OnPickUpItem(const EntityInfo& entity);
 	 
@@ -36,24 +38,40 @@ public:
 	bool IsHouseCleared(std::unordered_set<int>& unscannedArea, const HouseInfo& houseInfo);
 
 	void UpdateHouses(float deltaTime, IExamInterface* pInterface, const std::vector<HouseInfo*>& housesInFOV);
-	bool IsAreaExplored(std::unordered_set<int> area) const;
-	bool IsAreaExplored(std::unordered_set<int> area, std::unordered_set<int>& unscannedArea) const;
+	bool IsAreaExplored(const std::unordered_set<int>& area) const;
+	bool IsAreaExplored(const std::unordered_set<int>& area, std::unordered_set<int>& unscannedArea) const;
 
 private:
 	IExamInterface* m_pInterface;
 
 	Elite::InfluenceMap<InfluenceGrid>* m_pInfluenceMap{ nullptr };
 	Elite::GraphRenderer* m_pGraphRenderer{ nullptr };
+	Elite::GridRegions<Elite::WorldNode, Elite::GraphConnection>* m_pRegions{ nullptr };
+	float m_BlockingDanger{ -30.f }; // cells with more danger than this cut the regions the agent can reach
+	int m_RegionChangeList{ 0 };
+	std::vector<int> m_ChangedDangerCells{}; // reused every frame
 	float m_PropagationRadius;
+	unsigned int m_NrOfPropagationThreads{ 1 }; // 1 keeps propagation on the AI thread, more gives the influence map its own workers
+	float m_PropagationBudget{ 500.f }; // microseconds per frame, 0 propagates the whole map at once
+	float m_DangerChangeThreshold{ .5f }; // how far the danger of a cell moves before the path planner hears about it
 
 	std::unordered_set<int> m_LocatedItems{};
+	mutable std::vector<int> m_VisibleNodes{}; // reused every debug render
+	// the positions seen this frame and their nodes, converted in one batch
+	std::vector<Elite::Vector2> m_SeenPositions{};
+	std::vector<int> m_SeenNodes{};
+	std::vector<ItemInfo> m_SeenItems{};
 
 	int m_NrSeenHouses{};
 	std::unordered_map<int, EHouseInfo> m_LocatedHouses{};
 
 	float m_PercentageToClear{ .95f };
 
-	void LocateItem(const ItemInfo& item);
+	Elite::Vector2 GetHouseAreaSize(const HouseInfo& house) const;
+	bool IsHouseAreaExplored(const HouseInfo& house) const;
+	void LocateHouse(const HouseInfo& houseInfo, int houseNodeIdx);
+	bool IsHouseCleared(const HouseInfo& houseInfo, int houseNodeIdx);
+	void LocateItem(const ItemInfo& item, int nodeIdx);
 	void UpdateInfluenceMap(float deltaTime, IExamInterface* pInterface);
 	void UpdateEntities(IExamInterface* pInterface, std::vector<EntityInfo*> entitiesInFOV);
 };
@@ -19,12 +19,26 @@ void SteeringAgent::Render(float dt)
 	{
 		m_pInterface->Draw_Point(patrolPoint, 10, Elite::Vector3(0, 1, 0));
 	}
+
+	if (m_pCurrentSteering == m_pFollowPath)
+	{
+		Elite::Vector2 from{ GetLocation() };
+		for (const auto& waypoint : std::dynamic_pointer_cast<FollowPath>(m_pFollowPath)->GetWaypoints())
+		{
+			m_pInterface->Draw_Segment(from, waypoint, Elite::Vector3(1, 1, 0));
+			from = waypoint;
+		}
+	}
 	BaseAgent::Render(dt);
 }
 
 void SteeringAgent::Initialize(std::shared_ptr<SurvivorAgentMemory> pMemory)
 {
 	m_pSeek = std::make_shared<Seek>();
+
+	// Seeking goes along a path around the known danger
+	m_pFollowPath = std::make_shared<FollowPath>();
+	std::dynamic_pointer_cast<FollowPath>(m_pFollowPath)->Initialize(pMemory);
 	m_pLookAround = std::make_shared<LookAround>();
 	m_pLookAt = std::make_shared<LookAt>();
 
@@ -47,9 +61,15 @@ void SteeringAgent::Initialize(std::shared_ptr<SurvivorAgentMemory> pMemory)
 
 void SteeringAgent::SetToSeek(const Elite::Vector2& target, bool run)
 {
-	m_pSeek->SetRunMode(run);
-	m_pSeek->SetTarget(target);
-	m_pCurrentSteering = m_pSeek;
+	const auto pFollowPath{ std::dynamic_pointer_cast<FollowPath>(m_pFollowPath) };
+
+	// The path was planned from wherever the agent was when another behavior took over
+	if (m_pCurrentSteering != m_pFollowPath)
+		pFollowPath->Replan();
+
+	pFollowPath->SetRunMode(run);
+	pFollowPath->SetDestination(target);
+	m_pCurrentSteering = m_pFollowPath;
 }
 
 void SteeringAgent::SetTarget(const Elite::Vector2& target)
@@ -85,7 +105,7 @@ void SteeringAgent::SetToPatrol()
 	m_pCurrentSteering = m_pPatrol;
 }
 
-void SteeringAgent::SetToExploreArea(std::unordered_set<int> area)
+void SteeringAgent::SetToExploreArea(const std::unordered_set<int>& area)
 {
 	// Reset behavior (so that he doesn't go to his old target)
 	std::dynamic_pointer_cast<ClearArea>(m_pExploreArea)->SetReachedTarget(true);
@@ -46,7 +46,7 @@ public:
 	void SetToNavigateInfluenceMap();
 	void SetToPatrol();
 
-	void SetToExploreArea(std::unordered_set<int> area);
+	void SetToExploreArea(const std::unordered_set<int>& area);
 	bool IsAreaExplored() const;
 
 
@@ -58,6 +58,7 @@ protected:
 	//Steering
 	std::shared_ptr<ISteeringBehavior> m_pCurrentSteering{ nullptr };
 	std::shared_ptr<ISteeringBehavior> m_pSeek;
+	std::shared_ptr<ISteeringBehavior> m_pFollowPath;
 	std::shared_ptr<ISteeringBehavior> m_pLookAround;
 	std::shared_ptr<ISteeringBehavior> m_pLookAt;
 	std::shared_ptr<ISteeringBehavior> m_pExploreArea;
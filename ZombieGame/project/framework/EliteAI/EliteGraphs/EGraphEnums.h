@@ -12,4 +12,12 @@ enum class TerrainType : int
 	Mud = 3,
 	// Node's with a value of over 200 000 are always isolated
 	Water = 200001
+};
+
+// How a grid lays out its node objects in memory, the node indices stay row major whatever the layout
+enum class GridNodeLayout
+{
+	Separate, // created one at a time, wherever the node pool has room
+	RowMajor, // one reserved run of the node pool, in index order
+	Morton // one reserved run in Z-order, so neighbors along both axes sit close together
 };
\ No newline at end of file
@@ -10,6 +10,12 @@
 #include "EGraphConnectionTypes.h"
 #include "EGraphNodeTypes.h"
 #include <unordered_set>
+#include <deque>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <thread>
+#include <immintrin.h>
 
 namespace Elite
 {
@@ -21,14 +27,47 @@ namespace Elite
 		GridGraph(int columns, int rows, int cellSize, bool isDirectionalGraph, bool isConnectedDiagonally, float costStraight = 1.f, float costDiagonal = 1.5);
 		void InitializeGrid(Vector2 pos, int columns, int rows, int cellSize, bool isDirectionalGraph, bool isConnectedDiagonally, float costStraight = 1.f, float costDiagonal = 1.5);
 
+		// The layout InitializeGrid creates the nodes in. The block layouts reserve one run of the graph's node pool for them,
+		// Morton orders them along the Z-order curve so the nodes of a radius query share cache lines in every direction.
+		GridNodeLayout GetNodeLayout() const { return m_NodeLayout; }
+		void SetNodeLayout(GridNodeLayout nodeLayout) { m_NodeLayout = nodeLayout; }
+		// position of the node in the node block, -1 for the separate layout
+		int GetNodeStorageIndex(int col, int row) const;
+		// the bits of column and row interleaved, column in the even bits
+		static uint32_t GetMortonCode(int col, int row);
+
 		using IGraph::GetNode;
 		T_NodeType* GetNode(int col, int row) const { return m_Nodes[GetIndex(col, row)]; }
-		const ConnectionList& GetConnections(const T_NodeType& node) const { return m_Connections[node.GetIndex()]; }
-		const ConnectionList& GetConnections(int idx) const { return m_Connections[idx]; }
+		const ConnectionList& GetConnections(const T_NodeType& node) const { return GetNodeConnections(node.GetIndex()); }
+		const ConnectionList& GetConnections(int idx) const { return GetNodeConnections(idx); }
+
+		// Implicit connections: every cell is connected to its (in bounds) neighbors with the default costs, worked out from its column and row
+		// instead of stored, so building the grid allocates nothing per connection. GetNodeConnections still hands out a list for the code
+		// that needs one, built the first time the node is asked for, on the thread that initialized the grid only (see m_BuildThreadId).
+		// Editing connections or nodes through the grid stores them all first.
+		bool IsUsingImplicitConnections() const { return m_UseImplicitConnections; }
+		void SetUseImplicitConnections(bool useImplicitConnections);
+		// Calls function(neighborIdx, cost) for every connection of the node, implicit connections never build a list
+		template <typename T_Function>
+		void ForEachNeighbor(int idx, T_Function function) const;
+
+		using IGraph::GetNodeConnections;
+		virtual const ConnectionList& GetNodeConnections(int idx) const override;
+		virtual int GetNrOfConnections() const override;
+
+		// the edits of IGraph, storing the connections first
+		void RemoveNode(int idx);
+		void AddConnection(T_ConnectionType* pConnection);
+		void RemoveConnection(int from, int to);
+		void RemoveConnection(T_ConnectionType* pConnection) { RemoveConnection(pConnection->GetFrom(), pConnection->GetTo()); }
+		void RemoveConnectionsToAdjacentNodes(int idx);
 
 		int GetRows() const { return m_NrOfRows; }
 		int GetColumns() const { return m_NrOfColumns; }
 		int GetCellSize() const { return m_CellSize; }
+		bool IsConnectedDiagonally() const { return m_IsConnectedDiagonally; }
+		float GetDefaultCostStraight() const { return m_DefaultCostStraight; }
+		float GetDefaultCostDiagonal() const { return m_DefaultCostDiagonal; }
 
 		bool IsWithinBounds(int col, int row) const;
 		int GetIndex(int col, int row) const { return row * m_NrOfColumns + col; }
@@ -43,8 +82,40 @@ namespace Elite
 		Vector2 GetNodeWorldPos(int idx) const override;
 
 		int GetNodeIdxAtWorldPos(const Elite::Vector2& pos) const override;
+		// GetNodeIdxAtWorldPos for a whole array of positions, 8 or 4 at a time with AVX2/SSE. Positions off the grid get invalid_node_index.
+		// The vector version resizes indices to match positions, its capacity is reused.
+		void GetNodeIndicesAtWorldPos(const Elite::Vector2* pPositions, int count, int* pIndices) const;
+		void GetNodeIndicesAtWorldPos(const std::vector<Elite::Vector2>& positions, std::vector<int>& indices) const;
+		// returns the inclusive column/row range of the cells overlapping the rect (centered on pos), false if the rect misses the grid
+		bool GetCellRangeInRect(const Elite::Vector2& pos, const Elite::Vector2& size, int& minCol, int& minRow, int& maxCol, int& maxRow) const;
+		// same, but only the cells with their node position inside the rect (the cells GetNodeIndicesInRect returns)
+		bool GetNodeRangeInRect(const Elite::Vector2& pos, const Elite::Vector2& size, int& minCol, int& minRow, int& maxCol, int& maxRow) const;
+		// inclusive column range of the nodes in the given row that lie within radius of pos, false if there are none
+		bool GetNodeSpanInRadius(const Elite::Vector2& pos, float radius, int row, int& minCol, int& maxCol) const;
 		inline std::unordered_set<int> GridGraph<T_NodeType, T_ConnectionType>::GetNodeIndicesInRadius(const Elite::Vector2& pos, float radius) const;
 		inline std::unordered_set<int> GridGraph<T_NodeType, T_ConnectionType>::GetNodeIndicesInRect(const Elite::Vector2& pos, const Elite::Vector2& size) const;
+		// Rasterized versions: the covered columns are worked out per row, nothing gets allocated and no connections are walked.
+		// They visit the nodes with their position inside the shape, row by row. The buffer is cleared first, its capacity is reused.
+		template <typename T_Function>
+		void ForEachNodeInRadius(const Elite::Vector2& pos, float radius, T_Function function) const;
+		template <typename T_Function>
+		void ForEachNodeInRect(const Elite::Vector2& pos, const Elite::Vector2& size, T_Function function) const;
+		void GetNodeIndicesInRadius(const Elite::Vector2& pos, float radius, std::vector<int>& indices) const;
+		void GetNodeIndicesInRect(const Elite::Vector2& pos, const Elite::Vector2& size, std::vector<int>& indices) const;
+
+		// Walks the cells the segment from -> to passes through in order (Amanatides-Woo), the part outside the grid is skipped.
+		// The predicate gets every node index and returns true to stop there, RayMarch returns that node or invalid_node_index.
+		template <typename T_Predicate>
+		int RayMarch(const Elite::Vector2& from, const Elite::Vector2& to, T_Predicate predicate) const;
+		// false when a cell isBlocking returns true for lies on the segment, the cells of both ends included
+		template <typename T_Predicate>
+		bool IsInLineOfSight(const Elite::Vector2& from, const Elite::Vector2& to, T_Predicate isBlocking) const;
+		// One RayMarch per target, the node every ray stopped at goes to pHits (when given)
+		template <typename T_Predicate>
+		void RayMarch(const Elite::Vector2& from, const Elite::Vector2* pTargets, int count, T_Predicate predicate, int* pHits = nullptr) const;
+		// count rays of the given length spread evenly over the cone around direction, angle is the full opening in radians
+		template <typename T_Predicate>
+		void RayMarchCone(const Elite::Vector2& from, const Elite::Vector2& direction, float angle, float length, int count, T_Predicate predicate, int* pHits = nullptr) const;
 
 		void AddConnectionsToAdjacentCells(int col, int row);
 		void AddConnectionsToAdjacentCells(int idx);
@@ -55,23 +126,38 @@ namespace Elite
 		int m_NrOfColumns;
 		int m_NrOfRows;
 		int m_CellSize;
+		float m_InverseCellSize; // world to cell is a multiply, shared by the single and batch lookups so they agree on the borders
 		Vector2 m_Offset{};
 
 		bool m_IsConnectedDiagonally;
 		float m_DefaultCostStraight;
 		float m_DefaultCostDiagonal;
 
+		GridNodeLayout m_NodeLayout{ GridNodeLayout::Separate };
+		const T_NodeType* m_pNodeBlock{ nullptr }; // start of the block layouts' run in the node pool
+
+		bool m_UseImplicitConnections{ false };
+		// The lists GetNodeConnections handed out and their connections (a deque so they never move). The const GetNodeConnections
+		// builds them, so two threads asking at once would race: only the thread that initialized the grid may, which is asserted.
+		// Other threads walk the implicit connections with ForEachNeighbor, it never builds anything
+		mutable ConnectionListVector m_ImplicitConnectionLists;
+		mutable std::deque<T_ConnectionType> m_ImplicitConnections;
+		std::thread::id m_BuildThreadId{ std::this_thread::get_id() };
+
 		const std::vector<Vector2> m_StraightDirections = { { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 } };
 		const std::vector<Vector2> m_DiagonalDirections = { { 1, 1 }, { -1, 1 }, { -1, -1 }, { 1, -1 } };
 
 		// graph creation helper functions
-		void AddConnectionsInDirections(int idx, int col, int row, std::vector<Vector2> directions);
+		void CreateNodeBlock(const Vector2& pos);
+		int GetNrOfGridConnections() const; // what AddConnectionsToAdjacentCells adds over the whole grid
+		void AddConnectionsInDirections(int idx, int col, int row, const std::vector<Vector2>& directions);
 
 		float CalculateConnectionCost(int fromIdx, int toIdx) const;
+		// implicit connections go straight in, without building their lists
+		virtual void BuildAdjacency(GraphAdjacency& adjacency) const override;
+		// narrows [tEnter, tExit] to the part of start + t * delta inside [0, size), false if nothing is left
+		static bool ClipRayToRange(float start, float delta, float size, float& tEnter, float& tExit);
 
-		void GetNodesInRadiusRecursive(T_NodeType* node, std::unordered_set<int>& idxCache, float radius, const Vector2& center) const;
-		void GetNodesInSquareRecursive(T_NodeType* node, std::unordered_set<int>& idxCache, const Vector2& position, const Vector2& size) const;
-		void GetNodesInRadius(std::unordered_set<int>& idxCache, float radius, const Vector2& center) const;
 		friend class GraphRenderer;
 
 	};
@@ -82,6 +168,7 @@ namespace Elite
 		, m_NrOfColumns(0)
 		, m_NrOfRows(0)
 		, m_CellSize(5)
+		, m_InverseCellSize(1.f / m_CellSize)
 		, m_IsConnectedDiagonally(true)
 		, m_DefaultCostStraight(1.f)
 		, m_DefaultCostDiagonal(1.5f)
@@ -101,6 +188,7 @@ namespace Elite
 		, m_NrOfColumns(columns)
 		, m_NrOfRows(rows)
 		, m_CellSize(cellSize)
+		, m_InverseCellSize(1.f / cellSize)
 		, m_IsConnectedDiagonally(isConnectedDiagonally)
 		, m_DefaultCostStraight(costStraight)
 		, m_DefaultCostDiagonal(costDiagonal)
@@ -123,23 +211,38 @@ namespace Elite
 		m_NrOfColumns = columns;
 		m_NrOfRows = rows;
 		m_CellSize = cellSize;
+		m_InverseCellSize = 1.f / cellSize;
 		m_IsConnectedDiagonally = isConnectedDiagonally;
 		m_DefaultCostStraight = costStraight;
 		m_DefaultCostDiagonal = costDiagonal;
 		m_Offset = pos;
+		m_ImplicitConnectionLists.clear();
+		m_ImplicitConnections.clear();
+		m_BuildThreadId = std::this_thread::get_id();
 
 		// Create all nodes
-		for (auto r = 0; r < m_NrOfRows; ++r)
+		if (m_NodeLayout != GridNodeLayout::Separate)
 		{
-			for (auto c = 0; c < m_NrOfColumns; ++c)
+			CreateNodeBlock(pos);
+		}
+		else
+		{
+			for (auto r = 0; r < m_NrOfRows; ++r)
 			{
-				int idx = GetIndex(c, r);
-				T_NodeType* n = new T_NodeType(idx, { pos.x + (r*m_CellSize),  pos.y + (c*m_CellSize)});
-				AddNode(n);
+				for (auto c = 0; c < m_NrOfColumns; ++c)
+				{
+					int idx = GetIndex(c, r);
+					T_NodeType* n = CreateNode(idx, Vector2{ pos.x + (r*m_CellSize),  pos.y + (c*m_CellSize)});
+					AddNode(n);
+				}
 			}
 		}
 
+		if (m_UseImplicitConnections)
+			return;
+
 		// Create connections in each valid direction on each node
+		ReserveConnections(GetNrOfGridConnections());
 		for (auto r = 0; r < m_NrOfRows; ++r)
 		{
 			for (auto c = 0; c < m_NrOfColumns; ++c)
@@ -149,6 +252,76 @@ namespace Elite
 		}
 	}
 
+	template<class T_NodeType, class T_ConnectionType>
+	void GridGraph<T_NodeType, T_ConnectionType>::CreateNodeBlock(const Vector2& pos)
+	{
+		assert(m_Nodes.empty() && "<GridGraph::CreateNodeBlock>: the grid already has nodes");
+
+		// the order the nodes sit in the block
+		std::vector<int> order(m_NrOfColumns * m_NrOfRows);
+		for (int idx = 0; idx < static_cast<int>(order.size()); ++idx)
+			order[idx] = idx;
+
+		if (m_NodeLayout == GridNodeLayout::Morton)
+		{
+			std::sort(order.begin(), order.end(), [this](int a, int b)
+				{
+					return GetMortonCode(a % m_NrOfColumns, a / m_NrOfColumns) < GetMortonCode(b % m_NrOfColumns, b / m_NrOfColumns);
+				});
+		}
+
+		// reserved up front, so the nodes follow each other in the pool
+		std::vector<T_NodeType*> nodes(order.size());
+		ReserveNodes(order.size());
+		for (int idx : order)
+		{
+			const int c{ idx % m_NrOfColumns };
+			const int r{ idx / m_NrOfColumns };
+			nodes[idx] = CreateNode(idx, Vector2{ pos.x + (r * m_CellSize), pos.y + (c * m_CellSize) });
+		}
+		m_pNodeBlock = nodes.empty() ? nullptr : nodes[order.front()];
+
+		// the graph still gets them in index order
+		for (T_NodeType* pNode : nodes)
+			AddNode(pNode);
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	int GridGraph<T_NodeType, T_ConnectionType>::GetNrOfGridConnections() const
+	{
+		// both directions of every neighboring pair, whether the graph is directional or not
+		int nrOfPairs{ (m_NrOfColumns - 1) * m_NrOfRows + m_NrOfColumns * (m_NrOfRows - 1) };
+		if (m_IsConnectedDiagonally)
+			nrOfPairs += 2 * (m_NrOfColumns - 1) * (m_NrOfRows - 1);
+		return 2 * max(nrOfPairs, 0);
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	int GridGraph<T_NodeType, T_ConnectionType>::GetNodeStorageIndex(int col, int row) const
+	{
+		if (!m_pNodeBlock)
+			return -1;
+
+		return static_cast<int>(m_Nodes[GetIndex(col, row)] - m_pNodeBlock);
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	uint32_t GridGraph<T_NodeType, T_ConnectionType>::GetMortonCode(int col, int row)
+	{
+		// spread the lower 16 bits out over the even bits
+		const auto spreadBits = [](uint32_t value)
+		{
+			value &= 0x0000ffff;
+			value = (value | (value << 8)) & 0x00ff00ff;
+			value = (value | (value << 4)) & 0x0f0f0f0f;
+			value = (value | (value << 2)) & 0x33333333;
+			value = (value | (value << 1)) & 0x55555555;
+			return value;
+		};
+
+		return spreadBits(static_cast<uint32_t>(col)) | (spreadBits(static_cast<uint32_t>(row)) << 1);
+	}
+
 	template<class T_NodeType, class T_ConnectionType>
 	bool GridGraph<T_NodeType, T_ConnectionType>::IsWithinBounds(int col, int row) const
 	{
@@ -172,6 +345,148 @@ namespace Elite
 		OnGraphModified(false, true);
 	}
 
+	template<class T_NodeType, class T_ConnectionType>
+	void GridGraph<T_NodeType, T_ConnectionType>::SetUseImplicitConnections(bool useImplicitConnections)
+	{
+		if (useImplicitConnections == m_UseImplicitConnections)
+			return;
+
+		m_UseImplicitConnections = useImplicitConnections;
+		m_ImplicitConnectionLists.clear();
+		m_ImplicitConnections.clear();
+		InvalidateAdjacency();
+
+		// the stored connections make way for the implicit ones or the other way around
+		for (auto& connectionList : m_Connections)
+		{
+			for (auto& connection : connectionList)
+				DeleteConnection(connection);
+			connectionList.clear();
+		}
+
+		if (!m_UseImplicitConnections)
+		{
+			ReserveConnections(GetNrOfGridConnections());
+			for (auto r = 0; r < m_NrOfRows; ++r)
+			{
+				for (auto c = 0; c < m_NrOfColumns; ++c)
+				{
+					AddConnectionsToAdjacentCells(c, r);
+				}
+			}
+		}
+
+		OnGraphModified(false, true);
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	template<typename T_Function>
+	inline void GridGraph<T_NodeType, T_ConnectionType>::ForEachNeighbor(int idx, T_Function function) const
+	{
+		if (!m_UseImplicitConnections)
+		{
+			for (const auto neighbor : GetNeighbors(idx))
+				function(neighbor.to, neighbor.cost);
+			return;
+		}
+
+		// the straight directions followed by the diagonal ones, same order as m_StraightDirections and m_DiagonalDirections
+		static constexpr int columnOffsets[8]{ 1, 0, -1, 0, 1, -1, -1, 1 };
+		static constexpr int rowOffsets[8]{ 0, 1, 0, -1, 1, 1, -1, -1 };
+
+		const int col{ idx % m_NrOfColumns };
+		const int row{ idx / m_NrOfColumns };
+		const int nrOfDirections{ m_IsConnectedDiagonally ? 8 : 4 };
+		for (int direction = 0; direction < nrOfDirections; ++direction)
+		{
+			const int neighborCol{ col + columnOffsets[direction] };
+			const int neighborRow{ row + rowOffsets[direction] };
+			if (IsWithinBounds(neighborCol, neighborRow))
+				function(GetIndex(neighborCol, neighborRow), direction < 4 ? m_DefaultCostStraight : m_DefaultCostDiagonal);
+		}
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	void GridGraph<T_NodeType, T_ConnectionType>::BuildAdjacency(GraphAdjacency& adjacency) const
+	{
+		if (!m_UseImplicitConnections)
+		{
+			IGraph::BuildAdjacency(adjacency);
+			return;
+		}
+
+		adjacency.Build(static_cast<int>(m_Nodes.size()), [this](int idx, auto add) { ForEachNeighbor(idx, add); });
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	const typename GridGraph<T_NodeType, T_ConnectionType>::ConnectionList& GridGraph<T_NodeType, T_ConnectionType>::GetNodeConnections(int idx) const
+	{
+		if (!m_UseImplicitConnections)
+			return IGraph::GetNodeConnections(idx);
+
+		assert(std::this_thread::get_id() == m_BuildThreadId && "<GridGraph::GetNodeConnections>: implicit connection lists are built on the thread that initialized the grid");
+		if (m_ImplicitConnectionLists.size() != m_Nodes.size())
+			m_ImplicitConnectionLists.resize(m_Nodes.size());
+
+		// every cell has a neighbor unless the grid is a single cell, so an empty list hasn't been built yet
+		ConnectionList& connections{ m_ImplicitConnectionLists[idx] };
+		if (connections.empty())
+		{
+			ForEachNeighbor(idx, [&](int neighborIdx, float cost)
+				{
+					m_ImplicitConnections.emplace_back(idx, neighborIdx, cost);
+					connections.push_back(&m_ImplicitConnections.back());
+				});
+		}
+
+		return connections;
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	int GridGraph<T_NodeType, T_ConnectionType>::GetNrOfConnections() const
+	{
+		if (!m_UseImplicitConnections)
+			return IGraph::GetNrOfConnections();
+
+		if (m_NrOfColumns == 0 || m_NrOfRows == 0)
+			return 0;
+
+		// every pair of neighbors is connected both ways
+		int nrOfNeighborPairs{ (m_NrOfColumns - 1) * m_NrOfRows + m_NrOfColumns * (m_NrOfRows - 1) };
+		if (m_IsConnectedDiagonally)
+			nrOfNeighborPairs += 2 * (m_NrOfColumns - 1) * (m_NrOfRows - 1);
+
+		return 2 * nrOfNeighborPairs;
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	void GridGraph<T_NodeType, T_ConnectionType>::RemoveNode(int idx)
+	{
+		SetUseImplicitConnections(false);
+		IGraph::RemoveNode(idx);
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	void GridGraph<T_NodeType, T_ConnectionType>::AddConnection(T_ConnectionType* pConnection)
+	{
+		SetUseImplicitConnections(false);
+		IGraph::AddConnection(pConnection);
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	void GridGraph<T_NodeType, T_ConnectionType>::RemoveConnection(int from, int to)
+	{
+		SetUseImplicitConnections(false);
+		IGraph::RemoveConnection(from, to);
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	void GridGraph<T_NodeType, T_ConnectionType>::RemoveConnectionsToAdjacentNodes(int idx)
+	{
+		SetUseImplicitConnections(false);
+		IGraph::RemoveConnectionsToAdjacentNodes(idx);
+	}
+
 	template<class T_NodeType, class T_ConnectionType>
 	inline void GridGraph<T_NodeType, T_ConnectionType>::AddConnectionsToAdjacentCells(int idx)
 	{
@@ -180,9 +495,9 @@ namespace Elite
 	}
 
 	template<class T_NodeType, class T_ConnectionType>
-	void GridGraph<T_NodeType, T_ConnectionType>::AddConnectionsInDirections(int idx, int col, int row, std::vector<Elite::Vector2> directions)
+	void GridGraph<T_NodeType, T_ConnectionType>::AddConnectionsInDirections(int idx, int col, int row, const std::vector<Elite::Vector2>& directions)
 	{
-		for (auto d : directions)
+		for (const auto& d : directions)
 		{
 			int neighborCol = col + (int)d.x;
 			int neighborRow = row + (int)d.y;
@@ -194,7 +509,7 @@ namespace Elite
 
 				if (IsUniqueConnection(idx, neighborIdx) 
 					&& connectionCost < 100000) //Extra check for different terrain types
-					AddConnection(new GraphConnection(idx, neighborIdx, connectionCost));
+					AddConnection(CreateConnection(idx, neighborIdx, connectionCost));
 			}
 		}
 	}
@@ -282,8 +597,8 @@ namespace Elite
 
 		int r, c;
 
-		r = static_cast<int>(position.x / m_CellSize);
-		c = static_cast<int>(position.y / m_CellSize);
+		r = static_cast<int>(position.x * m_InverseCellSize);
+		c = static_cast<int>(position.y * m_InverseCellSize);
 
 		if (!IsWithinBounds(c, r)) 
 			return idx;
@@ -292,95 +607,198 @@ namespace Elite
 	}
 
 	template<class T_NodeType, class T_ConnectionType>
-	void GridGraph<T_NodeType, T_ConnectionType>::GetNodesInRadiusRecursive(T_NodeType* node, std::unordered_set<int>& idxCache, float radius, const Vector2& center) const
+	void GridGraph<T_NodeType, T_ConnectionType>::GetNodeIndicesAtWorldPos(const Elite::Vector2* pPositions, int count, int* pIndices) const
 	{
-		// Check if the current node is within the specified radius of the center point
-		if (node->GetPosition().DistanceSquared(center) > radius * radius || idxCache.count(node->GetIndex() == 0))
-		{
-			return;
-		}
-
-		// Add the current node to the cache
-		idxCache.insert(node->GetIndex());
+		// same origin and steps as GetNodeIdxAtWorldPos, rows run along x and columns along y
+		const float originX{ m_Offset.x - m_CellSize / 2 };
+		const float originY{ m_Offset.y - m_CellSize / 2 };
+		const float* pCoordinates{ reinterpret_cast<const float*>(pPositions) }; // x0 y0 x1 y1 ...
+		int i{ 0 };
 
-		// Recursively process the child nodes
-		for (const auto& connection : GetConnections(node->GetIndex()))
+#if defined(__AVX2__)
 		{
-			// Check if the child node has already been processed
-			if (idxCache.count(connection->GetTo()) > 0)
+			const __m256 origin{ _mm256_setr_ps(originX, originY, originX, originY, originX, originY, originX, originY) };
+			const __m256 inverseCellSize{ _mm256_set1_ps(m_InverseCellSize) };
+			const __m256i rows{ _mm256_set1_epi32(m_NrOfRows) };
+			const __m256i columns{ _mm256_set1_epi32(m_NrOfColumns) };
+			const __m256i invalid{ _mm256_set1_epi32(invalid_node_index) };
+			const __m256i deinterleave{ _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7) };
+
+			for (; i + 8 <= count; i += 8)
 			{
-				continue;
+				// both loads hold 4 positions, sort them into 8 x's and 8 y's
+				const __m256 low{ _mm256_permutevar8x32_ps(_mm256_sub_ps(_mm256_loadu_ps(pCoordinates + 2 * i), origin), deinterleave) };
+				const __m256 high{ _mm256_permutevar8x32_ps(_mm256_sub_ps(_mm256_loadu_ps(pCoordinates + 2 * i + 8), origin), deinterleave) };
+				const __m256 x{ _mm256_permute2f128_ps(low, high, 0x20) };
+				const __m256 y{ _mm256_permute2f128_ps(low, high, 0x31) };
+
+				// truncation is floor for the positions that pass the >= 0 test, the others are rejected anyway.
+				// Too large to convert comes out as INT_MIN, the sign test catches those
+				const __m256i r{ _mm256_cvttps_epi32(_mm256_mul_ps(x, inverseCellSize)) };
+				const __m256i c{ _mm256_cvttps_epi32(_mm256_mul_ps(y, inverseCellSize)) };
+
+				const __m256 isPositive{ _mm256_and_ps(_mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_GE_OQ), _mm256_cmp_ps(y, _mm256_setzero_ps(), _CMP_GE_OQ)) };
+				const __m256i isInside{ _mm256_andnot_si256(_mm256_srai_epi32(_mm256_or_si256(r, c), 31), _mm256_and_si256(_mm256_cmpgt_epi32(rows, r), _mm256_cmpgt_epi32(columns, c))) };
+				const __m256i isValid{ _mm256_and_si256(_mm256_castps_si256(isPositive), isInside) };
+
+				const __m256i idx{ _mm256_add_epi32(_mm256_mullo_epi32(r, columns), c) };
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(pIndices + i), _mm256_blendv_epi8(invalid, idx, isValid));
 			}
+		}
+#endif
+		// SSE2 only, it is the baseline of every x64 target and of MSVC's default x86 /arch.
+		// MSVC compiles any intrinsic it is given without checking the target, so no SSE4.1 here
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		{
+			const __m128 origin{ _mm_setr_ps(originX, originY, originX, originY) };
+			const __m128 inverseCellSize{ _mm_set1_ps(m_InverseCellSize) };
+			const __m128i rows{ _mm_set1_epi32(m_NrOfRows) };
+			const __m128i columns{ _mm_set1_epi32(m_NrOfColumns) };
+			const __m128i invalid{ _mm_set1_epi32(invalid_node_index) };
 
-			auto childNode{ GetNode(connection->GetTo()) };
-			GetNodesInRadiusRecursive(childNode, idxCache, radius, center);
+			for (; i + 4 <= count; i += 4)
+			{
+				const __m128 low{ _mm_sub_ps(_mm_loadu_ps(pCoordinates + 2 * i), origin) };
+				const __m128 high{ _mm_sub_ps(_mm_loadu_ps(pCoordinates + 2 * i + 4), origin) };
+				const __m128 x{ _mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0)) };
+				const __m128 y{ _mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1)) };
+
+				const __m128i r{ _mm_cvttps_epi32(_mm_mul_ps(x, inverseCellSize)) };
+				const __m128i c{ _mm_cvttps_epi32(_mm_mul_ps(y, inverseCellSize)) };
+
+				const __m128 isPositive{ _mm_and_ps(_mm_cmpge_ps(x, _mm_setzero_ps()), _mm_cmpge_ps(y, _mm_setzero_ps())) };
+				const __m128i isInside{ _mm_andnot_si128(_mm_srai_epi32(_mm_or_si128(r, c), 31), _mm_and_si128(_mm_cmpgt_epi32(rows, r), _mm_cmpgt_epi32(columns, c))) };
+				const __m128i isValid{ _mm_and_si128(_mm_castps_si128(isPositive), isInside) };
+
+				// r * columns from two 32x32->64 multiplies (lanes 0, 2 and lanes 1, 3), the low halves are the products
+				const __m128i even{ _mm_mul_epu32(r, columns) };
+				const __m128i odd{ _mm_mul_epu32(_mm_srli_si128(r, 4), columns) };
+				const __m128i product{ _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))) };
+
+				const __m128i idx{ _mm_add_epi32(product, c) };
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pIndices + i), _mm_or_si128(_mm_and_si128(isValid, idx), _mm_andnot_si128(isValid, invalid)));
+			}
 		}
+#endif
+
+		for (; i < count; ++i)
+			pIndices[i] = GridGraph::GetNodeIdxAtWorldPos(pPositions[i]);
 	}
 
 	template<class T_NodeType, class T_ConnectionType>
-	void GridGraph<T_NodeType, T_ConnectionType>::GetNodesInRadius(std::unordered_set<int>& idxCache, float radius, const Vector2& center) const
+	void GridGraph<T_NodeType, T_ConnectionType>::GetNodeIndicesAtWorldPos(const std::vector<Elite::Vector2>& positions, std::vector<int>& indices) const
 	{
-		// Create a queue to store the nodes that need to be processed
-		std::queue<int> nodesToProcess;
-
-		// Add the root node to the queue
-		nodesToProcess.push(GetNodeIdxAtWorldPos(center));
+		indices.resize(positions.size());
+		if (!positions.empty())
+			GetNodeIndicesAtWorldPos(positions.data(), static_cast<int>(positions.size()), indices.data());
+	}
 
-		// Process the nodes in the queue
-		while (!nodesToProcess.empty())
-		{
-			// Get the next node from the queue
-			auto node = nodesToProcess.front();
-			nodesToProcess.pop();
+	template<class T_NodeType, class T_ConnectionType>
+	inline bool GridGraph<T_NodeType, T_ConnectionType>::GetCellRangeInRect(const Elite::Vector2& pos, const Elite::Vector2& size, int& minCol, int& minRow, int& maxCol, int& maxRow) const
+	{
+		// same origin as GetNodeIdxAtWorldPos, rows run along x and columns along y
+		const float originX{ m_Offset.x - m_CellSize / 2 };
+		const float originY{ m_Offset.y - m_CellSize / 2 };
+
+		minRow = static_cast<int>(std::floor((pos.x - size.x / 2.f - originX) / m_CellSize));
+		maxRow = static_cast<int>(std::floor((pos.x + size.x / 2.f - originX) / m_CellSize));
+		minCol = static_cast<int>(std::floor((pos.y - size.y / 2.f - originY) / m_CellSize));
+		maxCol = static_cast<int>(std::floor((pos.y + size.y / 2.f - originY) / m_CellSize));
+
+		if (maxRow < 0 || maxCol < 0 || minRow >= m_NrOfRows || minCol >= m_NrOfColumns)
+			return false;
+
+		minRow = Clamp(minRow, 0, m_NrOfRows - 1);
+		minCol = Clamp(minCol, 0, m_NrOfColumns - 1);
+		maxRow = Clamp(maxRow, 0, m_NrOfRows - 1);
+		maxCol = Clamp(maxCol, 0, m_NrOfColumns - 1);
+		return true;
+	}
 
-			// Check if the current node is within the specified radius of the center point
-			if (idxCache.count(node) == 0 && GetNode(node)->GetPosition().DistanceSquared(center) <= radius * radius)
-			{
-				// Add the current node to the cache
-				idxCache.insert(node);
+	template<class T_NodeType, class T_ConnectionType>
+	inline bool GridGraph<T_NodeType, T_ConnectionType>::GetNodeRangeInRect(const Elite::Vector2& pos, const Elite::Vector2& size, int& minCol, int& minRow, int& maxCol, int& maxRow) const
+	{
+		// nodes sit at m_Offset + (row, col) * m_CellSize
+		minRow = static_cast<int>(std::ceil((pos.x - size.x / 2.f - m_Offset.x) / m_CellSize));
+		maxRow = static_cast<int>(std::floor((pos.x + size.x / 2.f - m_Offset.x) / m_CellSize));
+		minCol = static_cast<int>(std::ceil((pos.y - size.y / 2.f - m_Offset.y) / m_CellSize));
+		maxCol = static_cast<int>(std::floor((pos.y + size.y / 2.f - m_Offset.y) / m_CellSize));
+
+		minRow = max(minRow, 0);
+		minCol = max(minCol, 0);
+		maxRow = min(maxRow, m_NrOfRows - 1);
+		maxCol = min(maxCol, m_NrOfColumns - 1);
+		return minRow <= maxRow && minCol <= maxCol;
+	}
 
-				// Add the child nodes to the queue
-				for (const auto& connection : GetConnections(node))
-				{
-					// Check if the child node has already been processed
-					if (idxCache.count(connection->GetTo()) == 0)
-					{
-						nodesToProcess.push(connection->GetTo());
-					}
-				}
-			}
-		}
+	template<class T_NodeType, class T_ConnectionType>
+	inline bool GridGraph<T_NodeType, T_ConnectionType>::GetNodeSpanInRadius(const Elite::Vector2& pos, float radius, int row, int& minCol, int& maxCol) const
+	{
+		if (row < 0 || row >= m_NrOfRows)
+			return false;
+
+		// the row is a line along y at the x of its nodes, the circle cuts a chord out of it
+		const float distanceX{ m_Offset.x + row * m_CellSize - pos.x };
+		const float halfChordSquared{ radius * radius - distanceX * distanceX };
+		if (halfChordSquared < 0.f)
+			return false;
+
+		const float halfChord{ std::sqrt(halfChordSquared) };
+		minCol = static_cast<int>(std::ceil((pos.y - halfChord - m_Offset.y) / m_CellSize));
+		maxCol = static_cast<int>(std::floor((pos.y + halfChord - m_Offset.y) / m_CellSize));
+
+		minCol = max(minCol, 0);
+		maxCol = min(maxCol, m_NrOfColumns - 1);
+		return minCol <= maxCol;
 	}
 
 	template<class T_NodeType, class T_ConnectionType>
-	void GridGraph<T_NodeType, T_ConnectionType>::GetNodesInSquareRecursive(T_NodeType* node, std::unordered_set<int>& idxCache, const Vector2& position, const Vector2& size) const
+	template<typename T_Function>
+	inline void GridGraph<T_NodeType, T_ConnectionType>::ForEachNodeInRadius(const Elite::Vector2& pos, float radius, T_Function function) const
 	{
-		// Calculate the half width and half height of the square
-		float halfWidth = size.x / 2.0f;
-		float halfHeight = size.y / 2.0f;
+		int minCol, minRow, maxCol, maxRow;
+		if (!GetNodeRangeInRect(pos, { radius * 2, radius * 2 }, minCol, minRow, maxCol, maxRow))
+			return;
 
-		// Check if the current node is within the square
-		if (node->GetPosition().x >= position.x - halfWidth && node->GetPosition().x <= position.x + halfWidth &&
-			node->GetPosition().y >= position.y - halfHeight && node->GetPosition().y <= position.y + halfHeight)
+		for (int row = minRow; row <= maxRow; ++row)
 		{
-			// Add the index of the current node to the cache
-			idxCache.insert(node->GetIndex());
+			if (!GetNodeSpanInRadius(pos, radius, row, minCol, maxCol))
+				continue;
+
+			for (int col = minCol; col <= maxCol; ++col)
+				function(GetIndex(col, row));
 		}
-		else // If the current node is not within the square, return without processing its connections
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	template<typename T_Function>
+	inline void GridGraph<T_NodeType, T_ConnectionType>::ForEachNodeInRect(const Elite::Vector2& pos, const Elite::Vector2& size, T_Function function) const
+	{
+		int minCol, minRow, maxCol, maxRow;
+		if (!GetNodeRangeInRect(pos, size, minCol, minRow, maxCol, maxRow))
 			return;
 
-		// Recursively process the child nodes
-		for (const auto& connection : GetConnections(node->GetIndex()))
+		for (int row = minRow; row <= maxRow; ++row)
 		{
-			// Check if the child node has already been processed
-			if (idxCache.count(connection->GetTo()) > 0)
-				continue;
-
-			auto childNode{ GetNode(connection->GetTo()) };
-			GetNodesInSquareRecursive(childNode, idxCache, position, size);
+			for (int col = minCol; col <= maxCol; ++col)
+				function(GetIndex(col, row));
 		}
 	}
 
+	template<class T_NodeType, class T_ConnectionType>
+	inline void GridGraph<T_NodeType, T_ConnectionType>::GetNodeIndicesInRadius(const Elite::Vector2& pos, float radius, std::vector<int>& indices) const
+	{
+		indices.clear();
+		ForEachNodeInRadius(pos, radius, [&indices](int idx) { indices.push_back(idx); });
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	inline void GridGraph<T_NodeType, T_ConnectionType>::GetNodeIndicesInRect(const Elite::Vector2& pos, const Elite::Vector2& size, std::vector<int>& indices) const
+	{
+		indices.clear();
+		ForEachNodeInRect(pos, size, [&indices](int idx) { indices.push_back(idx); });
+	}
+
 	template<class T_NodeType, class T_ConnectionType>
 	inline std::unordered_set<int> GridGraph<T_NodeType, T_ConnectionType>::GetNodeIndicesInRadius(const Elite::Vector2& pos, float radius) const
 	{
@@ -392,9 +810,7 @@ namespace Elite
 
 		idxCache.clear();
 
-		const auto& centerNode{ GetNode(idx) };
-
-		GetNodesInRadius(idxCache, radius, pos);
+		ForEachNodeInRadius(pos, radius, [&idxCache](int nodeIdx) { idxCache.insert(nodeIdx); });
 
 		return idxCache;
 	}
@@ -411,11 +827,127 @@ namespace Elite
 
 		idxCache.clear();
 
-		const auto& centerNode{ GetNode(idx) };
-
-		GetNodesInSquareRecursive(centerNode, idxCache, pos, size);
+		ForEachNodeInRect(pos, size, [&idxCache](int nodeIdx) { idxCache.insert(nodeIdx); });
 
 		return idxCache;
 	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	bool GridGraph<T_NodeType, T_ConnectionType>::ClipRayToRange(float start, float delta, float size, float& tEnter, float& tExit)
+	{
+		if (delta == 0.f)
+			return start >= 0.f && start < size;
+
+		float t0{ -start / delta };
+		float t1{ (size - start) / delta };
+		if (t0 > t1)
+			std::swap(t0, t1);
+
+		tEnter = max(tEnter, t0);
+		tExit = min(tExit, t1);
+		return tEnter <= tExit;
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	template<typename T_Predicate>
+	inline int GridGraph<T_NodeType, T_ConnectionType>::RayMarch(const Elite::Vector2& from, const Elite::Vector2& to, T_Predicate predicate) const
+	{
+		// in cells, same origin as GetNodeIdxAtWorldPos: u runs along the rows (x), v along the columns (y)
+		const float originX{ m_Offset.x - m_CellSize / 2 };
+		const float originY{ m_Offset.y - m_CellSize / 2 };
+		const float u{ (from.x - originX) * m_InverseCellSize };
+		const float v{ (from.y - originY) * m_InverseCellSize };
+		const float du{ (to.x - from.x) * m_InverseCellSize };
+		const float dv{ (to.y - from.y) * m_InverseCellSize };
+
+		// t goes from 0 at from to 1 at to
+		float tEnter{ 0.f };
+		float tExit{ 1.f };
+		if (!ClipRayToRange(u, du, static_cast<float>(m_NrOfRows), tEnter, tExit)
+			|| !ClipRayToRange(v, dv, static_cast<float>(m_NrOfColumns), tEnter, tExit))
+			return invalid_node_index;
+
+		// The end cell fixes the number of steps, so both ends land in the cells GetNodeIdxAtWorldPos gives whatever the rounding.
+		// An axis that reached its end cell stops stepping, a ray along an axis never steps the other one.
+		const float endU{ tExit < 1.f ? u + du * tExit : (to.x - originX) * m_InverseCellSize };
+		const float endV{ tExit < 1.f ? v + dv * tExit : (to.y - originY) * m_InverseCellSize };
+		int r{ Clamp(static_cast<int>(std::floor(u + du * tEnter)), 0, m_NrOfRows - 1) };
+		int c{ Clamp(static_cast<int>(std::floor(v + dv * tEnter)), 0, m_NrOfColumns - 1) };
+		const int endR{ Clamp(static_cast<int>(std::floor(endU)), 0, m_NrOfRows - 1) };
+		const int endC{ Clamp(static_cast<int>(std::floor(endV)), 0, m_NrOfColumns - 1) };
+		int nrOfSteps{ std::abs(endR - r) + std::abs(endC - c) };
+
+		// per axis the step direction and t at the next cell border. The border t's are worked out from the cell
+		// instead of adding up the t across a cell, long rays drift off the line otherwise
+		const int rowStep{ du > 0.f ? 1 : -1 };
+		const int columnStep{ dv > 0.f ? 1 : -1 };
+		const float rowBorder{ du > 0.f ? 1.f - u : -u };
+		const float columnBorder{ dv > 0.f ? 1.f - v : -v };
+		const float inverseDu{ du != 0.f ? 1.f / du : 0.f };
+		const float inverseDv{ dv != 0.f ? 1.f / dv : 0.f };
+		float rowBorderT{ (r + rowBorder) * inverseDu };
+		float columnBorderT{ (c + columnBorder) * inverseDv };
+
+		while (true)
+		{
+			const int idx{ GetIndex(c, r) };
+			if (predicate(idx))
+				return idx;
+
+			if (nrOfSteps-- == 0)
+				break;
+
+			if (c == endC || (r != endR && rowBorderT < columnBorderT))
+			{
+				r += rowStep;
+				rowBorderT = (r + rowBorder) * inverseDu;
+			}
+			else
+			{
+				c += columnStep;
+				columnBorderT = (c + columnBorder) * inverseDv;
+			}
+		}
+
+		return invalid_node_index;
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	template<typename T_Predicate>
+	inline bool GridGraph<T_NodeType, T_ConnectionType>::IsInLineOfSight(const Elite::Vector2& from, const Elite::Vector2& to, T_Predicate isBlocking) const
+	{
+		return RayMarch(from, to, isBlocking) == invalid_node_index;
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	template<typename T_Predicate>
+	inline void GridGraph<T_NodeType, T_ConnectionType>::RayMarch(const Elite::Vector2& from, const Elite::Vector2* pTargets, int count, T_Predicate predicate, int* pHits) const
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			const int hit{ RayMarch(from, pTargets[i], predicate) };
+			if (pHits)
+				pHits[i] = hit;
+		}
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	template<typename T_Predicate>
+	inline void GridGraph<T_NodeType, T_ConnectionType>::RayMarchCone(const Elite::Vector2& from, const Elite::Vector2& direction, float angle, float length, int count, T_Predicate predicate, int* pHits) const
+	{
+		const float directionAngle{ std::atan2(direction.y, direction.x) };
+		const float angleStep{ count > 1 ? angle / (count - 1) : 0.f };
+		const float firstAngle{ count > 1 ? directionAngle - angle / 2.f : directionAngle };
+
+		for (int i = 0; i < count; ++i)
+		{
+			const float rayAngle{ firstAngle + i * angleStep };
+			const Elite::Vector2 to{ from.x + std::cos(rayAngle) * length, from.y + std::sin(rayAngle) * length };
+
+			const int hit{ RayMarch(from, to, predicate) };
+			if (pHits)
+				pHits[i] = hit;
+		}
+	}
 }
 
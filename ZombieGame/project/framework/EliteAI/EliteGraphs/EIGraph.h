@@ -9,6 +9,9 @@
 
 #include "EGraphNodeTypes.h"
 #include "EGraphConnectionTypes.h"
+#include "EliteGraphUtilities/EGraphPool.h"
+#include "EliteGraphUtilities/EGraphAdjacency.h"
+#include "EliteGraphUtilities/EGraphNodeViews.h"
 #include <memory>
 #include <unordered_set>
 
@@ -31,16 +34,36 @@ namespace Elite
 		// Basic graph functionality
 		// -------------------------
 		T_NodeType* GetNode(int idx) const;
-		std::vector<T_NodeType*> GetNodes(std::unordered_set<int> indices) const;
+		// The nodes at the given indices (any container of ints), a view that doesn't allocate
+		template <typename T_Indices>
+		IndexedNodeView<T_NodeType, typename T_Indices::const_iterator> GetNodes(const T_Indices& indices) const { return { m_Nodes.data(), indices.begin(), indices.end() }; }
+		// the view keeps iterators into the container, a temporary would be gone before the view gets walked
+		template <typename T_Indices>
+		void GetNodes(const T_Indices&& indices) const = delete;
 		bool IsNodeValid(int idx) const;
+		// The nodes that weren't removed, GetActiveNodes walks them in place while GetAllNodes copies them into a vector
+		ActiveNodeView<T_NodeType> GetActiveNodes() const { return { m_Nodes.data(), m_Nodes.data() + m_Nodes.size() }; }
 		NodeVector GetAllNodes() const;
 
 		T_ConnectionType* GetConnection(int from, int to) const;
 		const ConnectionListVector& GetAllConnections() const { return m_Connections; }
-		const ConnectionList& GetNodeConnections(int idx) const;
+		virtual const ConnectionList& GetNodeConnections(int idx) const;
 		const ConnectionList& GetNodeConnections(T_NodeType* pNode) const { return GetNodeConnections(pNode->GetIndex()); }
+		// The to-indices and costs of the node's connections from a contiguous copy of all of them (see GraphAdjacency).
+		// The copy is made in one go on first use, edits of single connections are patched in, other edits drop it until the next call.
+		GraphAdjacency::NeighborSpan GetNeighbors(int idx) const;
+		GraphAdjacency::NeighborSpan GetNeighbors(T_NodeType* pNode) const { return GetNeighbors(pNode->GetIndex()); }
+		// Makes the copy now if it isn't there. GetNeighbors isn't safe to call from several threads while the copy gets made,
+		// code that hands the graph to worker threads calls this on its own thread first
+		void EnsureAdjacency() const;
 
 		int GetNextFreeNodeIndex() const { return m_NextNodeIndex; }
+		// Nodes and connections made here live in the graph's pools and still go through AddNode/AddConnection.
+		// AddNode/AddConnection keep taking objects made with new as well, the graph deletes those one by one.
+		template <typename... T_Args>
+		T_NodeType* CreateNode(T_Args&&... args) { return m_NodePool.Create(std::forward<T_Args>(args)...); }
+		template <typename... T_Args>
+		T_ConnectionType* CreateConnection(T_Args&&... args) { return m_ConnectionPool.Create(std::forward<T_Args>(args)...); }
 		int AddNode(T_NodeType* pNode);
 		void RemoveNode(int node);
 
@@ -55,10 +78,12 @@ namespace Elite
 
 		int GetNrOfNodes() const { return m_Nodes.size(); }
 		int GetNrOfActiveNodes() const;
-		int GetNrOfConnections() const;
+		virtual int GetNrOfConnections() const;
 		bool IsDirectionalGraph() const { return m_IsDirectionalGraph; }
 		bool IsEmpty() const { return m_Nodes.empty(); }
 		bool IsUniqueConnection(int from, int to) const;
+		// Goes up with every edit of the nodes or connections, for the code that keeps something worked out from the graph
+		unsigned int GetRevision() const { return m_Revision; }
 
 		void Clear();
 		void RemoveConnections();
@@ -91,6 +116,19 @@ namespace Elite
 
 		bool m_IsDirectionalGraph;
 
+		// Storage of the nodes and connections made with CreateNode/CreateConnection, Clear hands it back in one go
+		GraphPool<T_NodeType> m_NodePool;
+		GraphPool<T_ConnectionType> m_ConnectionPool;
+		void ReserveNodes(size_t nrOfNodes) { m_NodePool.Reserve(nrOfNodes); }
+		void ReserveConnections(size_t nrOfConnections) { m_ConnectionPool.Reserve(nrOfConnections); }
+		// gives a connection back to its pool or deletes it, whichever made it
+		void DeleteConnection(T_ConnectionType*& pConnection);
+
+		// to be called by derived classes that change the connections behind IGraph's back
+		void InvalidateAdjacency() { m_IsAdjacencyValid = false; ++m_Revision; }
+		// Fills the contiguous copy GetNeighbors hands out, derived graphs whose connections aren't all stored can skip the lists
+		virtual void BuildAdjacency(GraphAdjacency& adjacency) const;
+
 
 		// Called whenever the graph is modified, to be overriden by derived classes
 		virtual void OnGraphModified(bool nrOfNodesChanged, bool nrOfConnectionsChanged) {}
@@ -98,6 +136,10 @@ namespace Elite
 	private:
 		int m_NextNodeIndex;
 
+		mutable GraphAdjacency m_Adjacency;
+		mutable bool m_IsAdjacencyValid{ false };
+		unsigned int m_Revision{ 0 };
+
 		// private functions
 		void CullInvalidEdges();
 	};
@@ -112,23 +154,16 @@ namespace Elite
 	template<class T_NodeType, class T_ConnectionType>
 	inline IGraph<T_NodeType, T_ConnectionType>::IGraph(const IGraph& other)
 	{
-		for (auto& n : m_Nodes)
-			SAFE_DELETE(n);
-
-		for (auto& connectionList : m_Connections)
-		{
-			for (auto& connection : connectionList)
-				SAFE_DELETE(connection);
-		};
-
+		m_NodePool.Reserve(other.m_Nodes.size());
 		for (auto n : other.m_Nodes)
-			m_Nodes.push_back(new T_NodeType(*n));
+			m_Nodes.push_back(CreateNode(*n));
 
+		m_ConnectionPool.Reserve(other.IGraph::GetNrOfConnections()); // the stored ones, not what a derived graph reports
 		for (auto cList : other.m_Connections)
 		{
 			ConnectionList newList;
 			for (auto c : cList)
-				newList.push_back(new T_ConnectionType(*c));
+				newList.push_back(CreateConnection(*c));
 			m_Connections.push_back(newList);
 		}
 
@@ -150,20 +185,6 @@ namespace Elite
 		return m_Nodes[idx];
 	}
 
-	template<class T_NodeType, class T_ConnectionType>
-	inline std::vector<T_NodeType*> IGraph<T_NodeType, T_ConnectionType>::GetNodes(std::unordered_set<int> indices) const
-	{
-		//assert( indices.empty() ) && "<Graph::GetNode>: invalid index");
-		
-		std::vector<T_NodeType*> nodes{};
-		for (const int idx : indices)
-		{
-			nodes.push_back(m_Nodes[idx]);
-		}
-
-		return nodes;
-	}
-
 
 	template<class T_NodeType, class T_ConnectionType>
 	inline bool IGraph<T_NodeType, T_ConnectionType>::IsNodeValid(int idx) const
@@ -184,7 +205,7 @@ namespace Elite
 			m_Nodes[to]->GetIndex() != invalid_node_index &&
 			"<Graph::GetConnection>: invalid 'to' index");
 
-		for (auto c : m_Connections[from])
+		for (auto c : GetNodeConnections(from))
 		{
 			if (c && c->GetTo() == to)
 				return c;
@@ -197,9 +218,8 @@ namespace Elite
 	inline std::vector<T_NodeType*> IGraph<T_NodeType, T_ConnectionType>::GetAllNodes() const
 	{
 		std::vector<T_NodeType*> activeNodes{};
-		for (auto n : m_Nodes)
-			if (n->GetIndex() != invalid_node_index)
-				activeNodes.push_back(n);
+		for (auto n : GetActiveNodes())
+			activeNodes.push_back(n);
 
 		return activeNodes;
 	}
@@ -212,6 +232,33 @@ namespace Elite
 		return m_Connections[idx];
 	}
 
+	template<class T_NodeType, class T_ConnectionType>
+	inline GraphAdjacency::NeighborSpan IGraph<T_NodeType, T_ConnectionType>::GetNeighbors(int idx) const
+	{
+		EnsureAdjacency();
+		return m_Adjacency.GetNeighbors(idx);
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	inline void IGraph<T_NodeType, T_ConnectionType>::EnsureAdjacency() const
+	{
+		if (m_IsAdjacencyValid)
+			return;
+
+		BuildAdjacency(m_Adjacency);
+		m_IsAdjacencyValid = true;
+	}
+
+	template<class T_NodeType, class T_ConnectionType>
+	inline void IGraph<T_NodeType, T_ConnectionType>::BuildAdjacency(GraphAdjacency& adjacency) const
+	{
+		adjacency.Build(static_cast<int>(m_Nodes.size()), [this](int idx, auto add)
+			{
+				for (const auto pConnection : GetNodeConnections(idx))
+					add(pConnection->GetTo(), pConnection->GetCost());
+			});
+	}
+
 	template<class T_NodeType, class T_ConnectionType>
 	inline int IGraph<T_NodeType, T_ConnectionType>::AddNode(T_NodeType* pNode)
 	{
@@ -224,6 +271,7 @@ namespace Elite
 
 			m_Nodes[pNode->GetIndex()] = pNode;
 
+			InvalidateAdjacency();
 			OnGraphModified(true, false);
 			return m_NextNodeIndex;
 		}
@@ -235,6 +283,7 @@ namespace Elite
 			m_Nodes.push_back(pNode);
 			m_Connections.push_back(ConnectionList());
 
+			InvalidateAdjacency();
 			OnGraphModified(true, false);
 			return m_NextNodeIndex++;
 		}
@@ -273,7 +322,7 @@ namespace Elite
 
 						auto conPtr = *currentEdgeOnToNode;
 						currentEdgeOnToNode = m_Connections[(*currentConnection)->GetTo()].erase(currentEdgeOnToNode);
-						SAFE_DELETE(conPtr);
+						DeleteConnection(conPtr);
 
 						break;
 					}
@@ -285,10 +334,11 @@ namespace Elite
 		for (auto& connection : m_Connections[idx])
 		{
 			hadConnections = true;
-			SAFE_DELETE(connection);
+			DeleteConnection(connection);
 		}
 		m_Connections[idx].clear();
 
+		InvalidateAdjacency();
 		OnGraphModified(true, hadConnections);
 	}
 
@@ -307,6 +357,9 @@ namespace Elite
 			assert(IsUniqueConnection(pConnection->GetFrom(), pConnection->GetTo()) && "Connection already exists on this graph");
 			
 			m_Connections[pConnection->GetFrom()].push_back(pConnection);
+			++m_Revision;
+			if (m_IsAdjacencyValid)
+				m_Adjacency.AddConnection(pConnection->GetFrom(), pConnection->GetTo(), pConnection->GetCost());
 
 			//if the graph is undirected we must add another pConnection in the opposite
 			//direction
@@ -315,13 +368,15 @@ namespace Elite
 				//check to make sure the pConnection is unique before adding
 				if (IsUniqueConnection(pConnection->GetTo(), pConnection->GetFrom()))
 				{
-					T_ConnectionType* oppositeDirEdge = new T_ConnectionType();
+					T_ConnectionType* oppositeDirEdge = CreateConnection();
 
 					oppositeDirEdge->SetCost(pConnection->GetCost());
 					oppositeDirEdge->SetTo(pConnection->GetFrom());
 					oppositeDirEdge->SetFrom(pConnection->GetTo());
 
 					m_Connections[pConnection->GetTo()].push_back(oppositeDirEdge);
+					if (m_IsAdjacencyValid)
+						m_Adjacency.AddConnection(pConnection->GetTo(), pConnection->GetFrom(), pConnection->GetCost());
 				}
 			}
 		}
@@ -363,8 +418,18 @@ namespace Elite
 			}
 		}
 
-		SAFE_DELETE(conFromTo);
-		SAFE_DELETE(conToFrom);
+		DeleteConnection(conFromTo);
+		// a directional graph keeps the opposite connection
+		if (!m_IsDirectionalGraph)
+			DeleteConnection(conToFrom);
+
+		++m_Revision;
+		if (m_IsAdjacencyValid)
+		{
+			m_Adjacency.RemoveConnection(from, to);
+			if (!m_IsDirectionalGraph)
+				m_Adjacency.RemoveConnection(to, from);
+		}
 
 		OnGraphModified(false, true);
 	}
@@ -380,7 +445,7 @@ namespace Elite
 	{
 		// remove and delete connections from this pNode
 		for (auto c : m_Connections[idx])
-			delete c;
+			DeleteConnection(c);
 		m_Connections[idx].clear();
 
 		// remove and delete connections from other nodes to this pNode
@@ -390,11 +455,12 @@ namespace Elite
 			std::list<T_ConnectionType*>::iterator foundIt;
 			while ((foundIt = std::find_if(c.begin(), c.end(), isConnectionToThisNode))	!= c.end())
 			{
-				delete *foundIt;
+				DeleteConnection(*foundIt);
 				c.erase(foundIt);
 			}
 		}
 
+		InvalidateAdjacency();
 		OnGraphModified(false, true);
 	}
 
@@ -410,12 +476,16 @@ namespace Elite
 			curEdge != m_Connections[from].end();
 			++curEdge)
 		{
-			if (curEdge->GetTo() == to)
+			if ((*curEdge)->GetTo() == to)
 			{
-				curEdge->SetCost(cost);
+				(*curEdge)->SetCost(cost);
 				break;
 			}
 		}
+
+		++m_Revision;
+		if (m_IsAdjacencyValid)
+			m_Adjacency.SetConnectionCost(from, to, cost);
 	}
 
 	template<class T_NodeType, class T_ConnectionType>
@@ -448,17 +518,32 @@ namespace Elite
 	template<class T_NodeType, class T_ConnectionType>
 	inline void IGraph<T_NodeType, T_ConnectionType>::Clear()
 	{
+		// The pooled ones only need their destructor, their memory goes back all at once below
 		for (auto& n : m_Nodes)
-			SAFE_DELETE(n);
+		{
+			if (n && m_NodePool.Owns(n))
+				n->~T_NodeType();
+			else
+				SAFE_DELETE(n);
+		}
 		m_Nodes.clear();
 
 		for (auto& connectionList : m_Connections)
 		{
 			for (auto& connection : connectionList)
-				SAFE_DELETE(connection);
+			{
+				if (connection && m_ConnectionPool.Owns(connection))
+					connection->~T_ConnectionType();
+				else
+					SAFE_DELETE(connection);
+			}
 		}
 		m_Connections.clear();
 
+		m_NodePool.Release();
+		m_ConnectionPool.Release();
+		InvalidateAdjacency();
+
 		m_NextNodeIndex = 0;
 	}
 
@@ -467,6 +552,8 @@ namespace Elite
 	{
 		for (auto& connectionList : m_Connections)
 			connectionList.clear();
+
+		InvalidateAdjacency();
 	}
 
 	template<class T_NodeType, class T_ConnectionType>
@@ -489,6 +576,18 @@ namespace Elite
 		return true;
 	}
 
+	template<class T_NodeType, class T_ConnectionType>
+	inline void IGraph<T_NodeType, T_ConnectionType>::DeleteConnection(T_ConnectionType*& pConnection)
+	{
+		if (pConnection && m_ConnectionPool.Owns(pConnection))
+		{
+			m_ConnectionPool.Destroy(pConnection);
+			pConnection = nullptr;
+		}
+		else
+			SAFE_DELETE(pConnection);
+	}
+
 	template<class T_NodeType, class T_ConnectionType>
 	inline void IGraph<T_NodeType, T_ConnectionType>::CullInvalidEdges()
 	{
@@ -2,36 +2,165 @@
 #include "EIGraph.h"
 #include "EGraphNodeTypes.h"
 #include "EGraphConnectionTypes.h"
+#include "EliteGraphUtilities/EInfluenceKernels.h"
+#include "EliteGraphUtilities/EGraphSearch.h"
+#include "../../EliteHelpers/EThreadPool.h"
 #include <unordered_set>
+#include <cstdint>
+#include <chrono>
+#include <climits>
+#include <cfloat>
+#include <memory>
+#include <algorithm>
 namespace Elite
 {
-	template<class T_GraphType>
+	// Influence, scanned state and item types are stored in flat arrays next to the grid (structure of arrays),
+	// the nodes only receive a copy of them when rendering (see SetNodeColorsBasedOnInfluence)
+	// Influence and items live in chunks that are only allocated once something gets written to them, the rest of the world reads as empty
+	// The influence can hold several layers (each with its own decay and momentum), interleaved per cell so they propagate in one pass
+	// The policy picks how a cell stores its influence (see FloatInfluence and FixedPointInfluence), the interface always talks float
+	template<class T_GraphType, class T_InfluencePolicy = FloatInfluence>
 	class InfluenceMap final : public T_GraphType
 	{
 	public:
 		InfluenceMap(bool isDirectional): T_GraphType(isDirectional) {}
-		void InitializeBuffer() { m_InfluenceDoubleBuffer = std::vector<float>(m_Nodes.size()); }
+		void InitializeBuffer();
 		void PropagateInfluence(float deltaTime);
 		void PropagateInfluence(float deltaTime, const Vector2& pos, float radius);
-		void SetInfluenceAtPosition(Elite::Vector2 pos, float influence);
-		void SetInfluenceAtPosition(int idx, float influence);
-		void SetInfluenceAtPosition(const std::unordered_set<int>& indices, float influence);
+		void SetInfluenceAtPosition(Elite::Vector2 pos, float influence, int layer = 0);
+		void SetInfluenceAtPosition(int idx, float influence, int layer = 0);
+		void SetInfluenceAtPosition(const std::unordered_set<int>& indices, float influence, int layer = 0);
 
 		void SetScannedAtPosition(int idx, bool scanned);
 		void SetScannedAtPosition(const std::unordered_set<int>& indices, bool scanned);
+		// Set whole row spans of the bitmap at once, they cover the same cells as GetNodeIndicesInRect/GetNodeIndicesInRadius
+		void SetScannedInRect(const Elite::Vector2& pos, const Elite::Vector2& size, bool scanned);
+		void SetScannedInRadius(const Elite::Vector2& pos, float radius, bool scanned);
+
+		float GetInfluence(int idx, int layer = 0) const { return T_InfluencePolicy::ToFloat(GetCellInfluence(idx % GetColumns(), idx / GetColumns())[layer]); }
+		float GetInfluence(int idx, const std::vector<float>& layerWeights) const;
+		float GetInfluenceAtPosition(const Elite::Vector2& pos, int layer = 0) const;
+		float GetInfluenceAtPosition(const Elite::Vector2& pos, const std::vector<float>& layerWeights) const;
+		bool IsScanned(int idx) const;
+
+		// Rect queries, cell ranges are inclusive. The scanned count pops the bits of every row span,
+		// the influence sum adds up the pyramid blocks that fit in the rect and the cells along its edge
+		int GetNrOfScannedCells(int minCol, int minRow, int maxCol, int maxRow) const;
+		float GetInfluenceSum(int minCol, int minRow, int maxCol, int maxRow, int layer = 0) const;
+		// world space versions, they cover the cells GetNodeIndicesInRect would return
+		float GetScannedRatioInRect(const Elite::Vector2& pos, const Elite::Vector2& size) const;
+		float GetAverageInfluenceInRect(const Elite::Vector2& pos, const Elite::Vector2& size, int layer = 0) const;
+
+		// Nearest unscanned cell of the target area, from a Euclidean distance transform of the scanned bitmap masked with that
+		// area. Only the rows whose bits changed and the columns that changed with them are redone on the next query.
+		// The target area is the whole grid until SetScanTargetArea narrows it. invalid_node_index when it's all scanned
+		int GetNearestUnscannedCell(int idx) const;
+		int GetNearestUnscannedCell(const Elite::Vector2& pos) const { return GetNearestUnscannedCell(GetNodeIdxAtWorldPos(pos)); }
+		float GetDistanceToUnscanned(int idx) const; // in cells, FLT_MAX when the target area is all scanned
+		// Unit direction from pos towards its nearest unscanned cell, zero when pos is on one
+		Elite::Vector2 GetUnscannedGradient(const Elite::Vector2& pos) const;
+		// Setting the same area again only compares the bits, the transform is redone for the rows where the area changed
+		void SetScanTargetArea(const std::unordered_set<int>& area);
+		void ResetScanTargetArea(); // the whole grid again
+		bool IsScanTargetAreaScanned() const;
+
+		// Queries on the min/max/sum pyramid, they only descend into the blocks that can still change the answer.
+		// The radius covers the cells GetNodeIndicesInRadius returns, the rect the ones of GetNodeIndicesInRect. 0 when no cell is covered.
+		float GetMinInfluenceInRadius(const Elite::Vector2& pos, float radius, int layer = 0) const;
+		float GetMaxInfluenceInRadius(const Elite::Vector2& pos, float radius, int layer = 0) const;
+		float GetMaxInfluenceInRadius(const Elite::Vector2& pos, float radius, const std::vector<float>& layerWeights) const;
+		float GetInfluenceSumInRadius(const Elite::Vector2& pos, float radius, int layer = 0) const;
+		float GetMinInfluenceInRect(const Elite::Vector2& pos, const Elite::Vector2& size, int layer = 0) const;
+		float GetMaxInfluenceInRect(const Elite::Vector2& pos, const Elite::Vector2& size, int layer = 0) const;
+		// Calls function(idx, influence) for every cell in the radius with a non-zero influence on the layer, blocks without influence are skipped
+		template <typename T_Function>
+		void ForEachInfluenceInRadius(const Elite::Vector2& pos, float radius, int layer, T_Function function) const;
+
+		// Danger-aware path queries: A* over the connections of the grid where stepping into a cell costs the connection cost
+		// plus a penalty for the negative influence it holds, so the path goes around danger whenever the detour is cheaper
+		struct PathSettings
+		{
+			int layer = 0; // the layer whose negative influence is avoided
+			float dangerPenalty = .1f; // extra cost per unit of negative influence, relative to the connection cost
+			float blockingInfluence = -FLT_MAX; // cells with less influence than this aren't entered at all (the start is)
+			int maxExpansions = 0; // nodes the search may take off the open list, 0 goes on until the goal is reached
+		};
+		// The cells from start to goal, true when the path gets there. The search stops as soon as the goal comes off the open list.
+		// When the budget runs out first (or blocking cells wall the goal off), the path leads to the cell that got closest to it instead
+		bool FindSafePath(int startIdx, int goalIdx, const PathSettings& settings, std::vector<int>& path) const;
+		// World space version, the cells are pulled tight into waypoints after start. A corner is only cut when the straight
+		// line doesn't cross more danger than the cells it cuts out, the last waypoint is goal itself when the path gets there
+		bool FindSafePath(const Elite::Vector2& start, const Elite::Vector2& goal, const PathSettings& settings, std::vector<Elite::Vector2>& waypoints) const;
+		// Pulls the cells of a path from any planner tight into waypoints after start, the way FindSafePath does with the danger
+		// on the layer. The last waypoint is the center of the last cell
+		void GetPathWaypoints(const Elite::Vector2& start, const std::vector<int>& cells, int layer, std::vector<Elite::Vector2>& waypoints) const;
+
+		// Change list for incremental planners (see DStarLite): the cells whose influence on the watched layer moved more than
+		// the threshold since they were last handed out. Filled after every sweep and by SetInfluenceAtPosition
+		void WatchChanges(int layer, float threshold);
+		bool IsWatchingChanges() const { return m_WatchedLayer >= 0; }
+		// Another list of the same changes for a second reader, the id goes to TakeChangedCells. WatchChanges makes list 0
+		int AddChangeList();
+		// Hands the cells of the list over and starts it again, a cell is in it once however often it changed
+		void TakeChangedCells(std::vector<int>& cells, int list = 0);
+		// The influence on the watched layer as the change list knows it, it only moves when the cell gets into the list.
+		// A planner that takes its costs from here agrees with what it was told, changes under the threshold included
+		float GetWatchedInfluence(int idx) const { return m_ReportedInfluence[idx]; }
+
+		eItemType GetItemType(int idx) const;
+		void SetItem(int idx, const ItemInfo& item);
+		void RemoveItem(int idx);
 
 		void Render() const {}
 		void SetNodeColorsBasedOnInfluence();
+		// weights used to combine the layers into the rendered influence, an empty list sums all layers
+		void SetRenderLayerWeights(const std::vector<float>& layerWeights) { m_RenderLayerWeights = layerWeights; }
 
-		float GetMomentum() const { return m_Momentum; }
-		void SetMomentum(float momentum) { m_Momentum = momentum; }
+		// Existing layers keep their influence, added ones start empty
+		int GetNrOfLayers() const { return m_NrOfLayers; }
+		void SetNrOfLayers(int nrOfLayers);
 
-		float GetDecay() const { return m_Decay; }
-		void SetDecay(float decay) { m_Decay = decay; }
+		// The setters without a layer apply to all layers
+		float GetMomentum(int layer = 0) const { return m_LayerMomentum[layer]; }
+		void SetMomentum(float momentum) { m_LayerMomentum.assign(m_NrOfLayers, momentum); }
+		void SetMomentum(int layer, float momentum) { m_LayerMomentum[layer] = momentum; }
+
+		float GetDecay(int layer = 0) const { return m_LayerDecay[layer]; }
+		void SetDecay(float decay) { m_LayerDecay.assign(m_NrOfLayers, decay); }
+		void SetDecay(int layer, float decay) { m_LayerDecay[layer] = decay; }
 
 		float GetPropagationInterval() const { return m_PropagationInterval; }
 		void SetPropagationInterval(float propagationInterval) { m_PropagationInterval = propagationInterval; }
 
+		// With a budget (in microseconds) a propagation is spread over several frames, 0 runs it in one go.
+		// A sweep still finishes within the propagation interval, frames that can't keep pace within the budget go over it.
+		float GetPropagationBudget() const { return m_PropagationBudget; }
+		void SetPropagationBudget(float microseconds) { m_PropagationBudget = microseconds; }
+
+		// Lag reporting for tuning the budget
+		float GetSweepProgress() const; // 0-1 of the running sweep, 1 when idle
+		float GetSweepLag() const { return m_SweepLag; } // fraction of the sweep the last frame had to do over budget
+		float GetLastSweepDuration() const { return m_LastSweepDuration; } // game time, in seconds
+		int GetNrOfOverBudgetFrames() const { return m_NrOfOverBudgetFrames; }
+
+		// The SIMD stencil is only used when the graph is still the untouched regular grid, otherwise the connections are walked
+		bool IsUsingGridKernel() const { return m_UseGridKernel && m_IsRegularGrid; }
+		void SetUseGridKernel(bool useGridKernel) { m_UseGridKernel = useGridKernel; }
+
+		// Only tiles that changed (or border a tile that changed) are propagated, a tile goes to sleep once none of its cells change more than this
+		float GetChangeThreshold() const { return m_ChangeThreshold; }
+		void SetChangeThreshold(float changeThreshold) { m_ChangeThreshold = changeThreshold; }
+		int GetNrOfDirtyTiles() const { return static_cast<int>(m_DirtyTiles.size()); }
+
+		// 0 or 1 (the default) propagates on the calling thread, more spawns that many - 1 workers (the calling thread helps out).
+		// The workers belong to this map, several maps with threads each start their own
+		unsigned int GetNrOfPropagationThreads() const { return m_pThreadPool ? m_pThreadPool->GetNrOfWorkers() + 1 : 1; }
+		void SetNrOfPropagationThreads(unsigned int nrOfThreads);
+
+		// Memory use, chunks of m_ChunkSize x m_ChunkSize cells
+		int GetNrOfChunks() const { return static_cast<int>(m_Chunks.size()); }
+		int GetNrOfAllocatedChunks() const { return m_NrOfAllocatedChunks; }
+
 	protected:
 		virtual void OnGraphModified(bool nrOfNodesChanged, bool nrOfConnectionsChanged) override;
 
@@ -42,121 +171,754 @@ namespace Elite
 
 		float m_MaxAbsInfluence = 100.f;
 		float m_PropagationRadius = 100.f;
-		float m_Momentum = 0.2f; // a higher momentum means a higher tendency to retain the current influence
-		float m_Decay = 0.5f; // determines the decay in influence over distance
+		int m_NrOfLayers = 1;
+		std::vector<float> m_LayerMomentum{ 0.2f }; // a higher momentum means a higher tendency to retain the current influence
+		std::vector<float> m_LayerDecay{ 0.5f }; // determines the decay in influence over distance
+		std::vector<float> m_RenderLayerWeights;
+		typename T_InfluencePolicy::Factors m_LayerFactors;
 
 		float m_PropagationInterval = .05f; //in Seconds
 		float m_TimeSinceLastPropagation = 0.0f;
 
-		std::vector<float> m_InfluenceDoubleBuffer;
+		// Budgeted sweeps, the cursor walks m_TilesInRange over several frames before the buffers get swapped
+		float m_PropagationBudget = 0.f; //in Microseconds
+		bool m_IsSweepActive = false;
+		int m_SweepCursor = 0;
+		float m_SweepDuration = 0.f;
+		float m_LastSweepDuration = 0.f;
+		float m_SweepLag = 0.f;
+		int m_NrOfOverBudgetFrames = 0;
+
+		bool m_UseGridKernel = true;
+		bool m_IsRegularGrid = false;
+		bool m_IsBufferDirty = true;
+
+		// Dirty tile bookkeeping, a clean tile holds the same values in both buffers so the buffers can simply be swapped
+		static constexpr int m_TileSize{ 16 };
+		float m_ChangeThreshold = 0.01f;
+		int m_TileColumns = 0;
+		int m_TileRows = 0;
+		std::vector<uint8_t> m_IsTileDirty;
+		std::vector<int> m_DirtyTiles;
+		std::vector<int> m_TilesToProcess;
+		std::vector<int> m_TilesInRange;
+		std::vector<uint8_t> m_HasTileChanged;
+
+		// The pool gets m_TilesInRange (the dirty tiles in the order they were marked, not grid rows) split into consecutive runs
+		// as long as a tile row, m_MinTilesPerThread at least. Batches of less than twice m_MinTilesPerThread tiles stay on the calling thread
+		static constexpr int m_MinTilesPerThread{ 8 };
+		std::unique_ptr<ThreadPool> m_pThreadPool{ nullptr };
+
+		// Per cell data of a square of cells, a tile never straddles two chunks
+		static constexpr int m_ChunkSize{ 32 };
+		using Value = typename T_InfluencePolicy::Value;
+		struct Chunk
+		{
+			std::vector<Value> influence[2]; // both buffers, m_NrOfLayers values per cell in rows of m_ChunkSize cells
+			std::vector<eItemType> itemTypes;
+		};
+		std::vector<std::unique_ptr<Chunk>> m_Chunks; // nullptr until touched
+		int m_NrOfAllocatedChunks = 0;
+		int m_ChunkColumns = 0;
+		int m_BufferColumns = 0;
+		int m_BufferRows = 0;
+		int m_FrontBuffer = 0; // the buffer of the chunks that holds the current influence, swapping the buffers flips it
+		Value m_ZeroCell[InfluenceKernels::MaxLayers]{}; // read for cells without a chunk and outside the grid
+
+		// Scanned state, one bit per cell. Every row starts on a new word so a span in a row is a run of masked words
+		std::vector<uint64_t> m_ScannedBits;
+		int m_ScannedWordsPerRow{ 0 };
+		std::vector<uint64_t> m_ScanTargetBits; // the cells the unscanned queries look for, same layout
+		std::vector<uint64_t> m_NewScanTargetBits; // scratch of SetScanTargetArea
+
+		// Squared distance (in cells) from every cell to the nearest unscanned one of the target area and which cell that is.
+		// The row pass keeps the nearest unscanned column within each row, the column pass takes the lower envelope of those.
+		mutable std::vector<int> m_RowUnscannedColumn; // -1 for a row without unscanned cells
+		mutable std::vector<float> m_UnscannedDistance;
+		mutable std::vector<int> m_NearestUnscanned;
+		mutable std::vector<int> m_EnvelopeRows; // scratch of the column pass, the row pass uses the rows for its sweep
+		mutable std::vector<float> m_EnvelopeBounds;
+		mutable int m_UnscannedDirtyMinRow = INT_MAX;
+		mutable int m_UnscannedDirtyMaxRow = -1;
+
+		// Lowest, highest and summed influence per block of cells, each level m_PyramidBranching times coarser than the one below it.
+		// The top level blocks are the propagation tiles, a tile whose influence changed gets rebuilt when a query reaches it.
+		static constexpr int m_PyramidBranching{ 4 };
+		struct InfluenceBlockLevel
+		{
+			int blockSize;
+			int columns;
+			int rows;
+			std::vector<float> lowest; // m_NrOfLayers values per block
+			std::vector<float> highest;
+			std::vector<float> sum;
+		};
+		mutable std::vector<InfluenceBlockLevel> m_Pyramid; // finest level first
+		mutable std::vector<uint8_t> m_IsPyramidTileDirty;
+
+		// Path queries, kept so a query doesn't allocate once they're big enough for the grid
+		struct PathRecord
+		{
+			float costSoFar = 0.f;
+			float heuristicCost = 0.f;
+			int fromIdx = invalid_node_index;
+		};
+		mutable SearchRecords<PathRecord> m_PathRecords;
+		mutable NodeHeap<EstimatedCostKey> m_PathOpenList;
+		mutable std::vector<int> m_PathCells; // the cells behind the waypoints of the world space query
+
+		// Change list, the influence of every cell as it was when the cell was last handed out
+		int m_WatchedLayer = -1;
+		float m_WatchThreshold = 0.f;
+		std::vector<float> m_ReportedInfluence;
+		static constexpr int m_MaxChangeLists{ 8 };
+		std::vector<uint8_t> m_IsCellChanged; // one bit per list
+		std::vector<std::vector<int>> m_ChangedCells = std::vector<std::vector<int>>(1);
+
+		// Cells covered by a query, a radius or a rect. The range bounds both.
+		enum class BlockOverlap { None, Partial, Full };
+		struct CellArea
+		{
+			int minCol, minRow, maxCol, maxRow;
+			bool isCircle;
+			Elite::Vector2 center;
+			float radius;
+		};
+
+		bool IsBufferValid(int idx) const { return idx >= 0 && idx < m_BufferColumns * m_BufferRows; }
+		int GetChunkIdx(int col, int row) const { return (row / m_ChunkSize) * m_ChunkColumns + col / m_ChunkSize; }
+		int GetChunkOffset(int col, int row) const { return (row % m_ChunkSize) * m_ChunkSize + col % m_ChunkSize; } // cell within its chunk
+		const Value* GetCellInfluence(int col, int row) const;
+		Chunk& TouchChunk(int chunkIdx);
+		void GatherTileRow(int row, int beginCol, int endCol, Value* pOut) const;
+		float CalculatePropagatedInfluence(int idx, int layer) const;
+		void MarkCellsDirty(int minCol, int minRow, int maxCol, int maxRow);
+		void MarkTileDirty(int tileIdx);
+		void CopyTileToBuffer(int tileIdx);
+		bool PropagateTile(int tileIdx);
+		void PropagateDirtyTiles(float deltaTime, int minCol, int minRow, int maxCol, int maxRow);
+		void BeginSweep(int minCol, int minRow, int maxCol, int maxRow);
+		void ContinueSweep(float deltaTime);
+		void PropagateTiles(int begin, int end);
+		void FinishSweep();
+		void SetScannedInRow(int row, int minCol, int maxCol, bool scanned);
+		static uint64_t GetWordMask(int word, int minCol, int maxCol);
+		void MarkUnscannedRowDirty(int row);
+		void UpdateUnscannedDistances() const;
+		void UpdateUnscannedColumn(int col) const;
+		void InitializePyramid();
+		void MarkPyramidTileDirty(int tileIdx) { m_IsPyramidTileDirty[tileIdx] = 1; }
+		void UpdatePyramidTile(int tileIdx) const;
+		float GetPathHeuristic(int fromIdx, int toIdx) const;
+		void CheckForChange(int idx);
+		bool GetCircleArea(const Elite::Vector2& pos, float radius, CellArea& area) const;
+		bool GetRectArea(const Elite::Vector2& pos, const Elite::Vector2& size, CellArea& area) const;
+		BlockOverlap GetBlockOverlap(const CellArea& area, int beginCol, int beginRow, int lastCol, int lastRow) const;
+		bool GetAreaSpan(const CellArea& area, int row, int& minCol, int& maxCol) const;
+		float GetExtremeInfluence(const CellArea& area, int layer, bool isMax) const;
+		double GetInfluenceSum(const CellArea& area, int layer) const;
+		template <typename T_Skip, typename T_Block, typename T_Cell>
+		void VisitArea(const CellArea& area, T_Skip skipBlock, T_Block onBlock, T_Cell onCell) const;
+		template <typename T_Skip, typename T_Block, typename T_Cell>
+		void VisitBlock(const CellArea& area, int level, int blockIdx, T_Skip& skipBlock, T_Block& onBlock, T_Cell& onCell) const;
 	};
 
-	template <class T_GraphType>
-	void InfluenceMap<T_GraphType>::PropagateInfluence(float deltaTime)
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::InitializeBuffer()
 	{
-		//make sure this function only executes once every interval
-		m_TimeSinceLastPropagation += deltaTime;
-		if (m_TimeSinceLastPropagation < m_PropagationInterval) return;
-		m_TimeSinceLastPropagation = 0;
+		static_assert(m_ChunkSize % m_TileSize == 0, "a tile has to fit in a single chunk");
 
-		m_InfluenceDoubleBuffer.clear();
+		const int columns{ GetColumns() };
+		const int rows{ GetRows() };
 
-		//go over all the nodes
-		for (const auto& node : GetAllNodes()) 
+		// The chunk and bitmap layout depend on the size of the grid, a different grid starts over from whatever its nodes hold
+		if (columns != m_BufferColumns || rows != m_BufferRows)
 		{
-			//get each neighbor node, check their influence
-			const auto connections{ GetNodeConnections(node->GetIndex()) };
-			
-			//check the influence of each neighboring node
-			float highestInfluence{ 0 };
-			for (const auto& connection : connections)
+			m_BufferColumns = columns;
+			m_BufferRows = rows;
+			m_ChunkColumns = (columns + m_ChunkSize - 1) / m_ChunkSize;
+			m_Chunks.clear();
+			m_Chunks.resize(m_ChunkColumns * ((rows + m_ChunkSize - 1) / m_ChunkSize));
+			m_NrOfAllocatedChunks = 0;
+			m_FrontBuffer = 0;
+
+			m_ScannedWordsPerRow = (columns + 63) / 64;
+			m_ScannedBits.assign(static_cast<size_t>(m_ScannedWordsPerRow) * rows, 0);
+			m_ScanTargetBits.assign(m_ScannedBits.size(), ~uint64_t{ 0 });
+
+			for (int idx = 0; idx < columns * rows && idx < static_cast<int>(m_Nodes.size()); ++idx)
 			{
-				const float newInfluence{ GetNode(connection->GetTo())->GetInfluence() * std::expf(-connection->GetCost() * GetDecay())};
+				const auto pNode{ m_Nodes[idx] };
+				if (!pNode)
+					continue;
+
+				const int col{ idx % columns };
+				const int row{ idx / columns };
+				if (pNode->GetInfluence() != 0.f)
+					TouchChunk(GetChunkIdx(col, row)).influence[m_FrontBuffer][GetChunkOffset(col, row) * m_NrOfLayers] = T_InfluencePolicy::FromFloat(pNode->GetInfluence());
+				if (pNode->GetItem() != eItemType::INVALID)
+					TouchChunk(GetChunkIdx(col, row)).itemTypes[GetChunkOffset(col, row)] = pNode->GetItem();
+				if (pNode->GetScanned())
+					SetScannedInRow(row, col, col, true);
+			}
+		}
+
+		// The stencil assumes every cell is connected to all of its (in bounds) neighbours with the default costs
+		const int nrOfNodes{ static_cast<int>(m_Nodes.size()) };
+		int expectedConnections{ (columns - 1) * rows + columns * (rows - 1) };
+		if (IsConnectedDiagonally())
+			expectedConnections += 2 * (columns - 1) * (rows - 1);
+
+		m_IsRegularGrid = nrOfNodes == columns * rows
+			&& GetNrOfConnections() == 2 * expectedConnections
+			&& GetNrOfActiveNodes() == nrOfNodes;
+
+		// Start with both buffers in sync, only the tiles around cells that hold influence need propagating
+		for (auto& pChunk : m_Chunks)
+		{
+			if (pChunk)
+				pChunk->influence[m_FrontBuffer ^ 1] = pChunk->influence[m_FrontBuffer];
+		}
+		m_TileColumns = (columns + m_TileSize - 1) / m_TileSize;
+		m_TileRows = (rows + m_TileSize - 1) / m_TileSize;
+		m_IsTileDirty.assign(m_TileColumns * m_TileRows, 0);
+		m_DirtyTiles.clear();
+		m_IsSweepActive = false; // a running sweep was working on the old buffers
+		m_IsBufferDirty = false;
+		m_UnscannedDirtyMinRow = 0;
+		m_UnscannedDirtyMaxRow = rows - 1;
+		InitializePyramid();
+
+		for (int row = 0; row < rows; ++row)
+		{
+			for (int col = 0; col < columns; ++col)
+			{
+				const Value* pCell{ GetCellInfluence(col, row) };
+				if (std::any_of(pCell, pCell + m_NrOfLayers, [](Value influence) { return influence != Value{}; }))
+					MarkCellsDirty(col, row, col, row);
+			}
+		}
+
+		// a grid of another size starts a new change list
+		if (IsWatchingChanges() && static_cast<int>(m_ReportedInfluence.size()) != columns * rows)
+			WatchChanges(m_WatchedLayer, m_WatchThreshold);
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	inline const typename InfluenceMap<T_GraphType, T_InfluencePolicy>::Value* InfluenceMap<T_GraphType, T_InfluencePolicy>::GetCellInfluence(int col, int row) const
+	{
+		if (col < 0 || col >= m_BufferColumns || row < 0 || row >= m_BufferRows)
+			return m_ZeroCell;
+
+		const Chunk* pChunk{ m_Chunks[GetChunkIdx(col, row)].get() };
+		return pChunk ? pChunk->influence[m_FrontBuffer].data() + GetChunkOffset(col, row) * m_NrOfLayers : m_ZeroCell;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	typename InfluenceMap<T_GraphType, T_InfluencePolicy>::Chunk& InfluenceMap<T_GraphType, T_InfluencePolicy>::TouchChunk(int chunkIdx)
+	{
+		auto& pChunk{ m_Chunks[chunkIdx] };
+		if (!pChunk)
+		{
+			// both buffers start out empty, so they agree like any sleeping tile
+			pChunk = std::make_unique<Chunk>();
+			pChunk->influence[0].assign(m_ChunkSize * m_ChunkSize * m_NrOfLayers, Value{});
+			pChunk->influence[1].assign(m_ChunkSize * m_ChunkSize * m_NrOfLayers, Value{});
+			pChunk->itemTypes.assign(m_ChunkSize * m_ChunkSize, eItemType::INVALID);
+			++m_NrOfAllocatedChunks;
+		}
+
+		return *pChunk;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::SetNrOfLayers(int nrOfLayers)
+	{
+		assert(nrOfLayers > 0 && nrOfLayers <= InfluenceKernels::MaxLayers);
+		if (nrOfLayers == m_NrOfLayers)
+			return;
+
+		// new layers start with the settings of the first one
+		m_LayerMomentum.resize(nrOfLayers, m_LayerMomentum[0]);
+		m_LayerDecay.resize(nrOfLayers, m_LayerDecay[0]);
+
+		// the back buffer gets synced again when the buffer is rebuilt below
+		for (auto& pChunk : m_Chunks)
+		{
+			if (!pChunk)
+				continue;
+
+			std::vector<Value> influence(m_ChunkSize * m_ChunkSize * nrOfLayers, Value{});
+			for (int cell = 0; cell < m_ChunkSize * m_ChunkSize; ++cell)
+			{
+				for (int layer = 0; layer < nrOfLayers && layer < m_NrOfLayers; ++layer)
+					influence[cell * nrOfLayers + layer] = pChunk->influence[m_FrontBuffer][cell * m_NrOfLayers + layer];
+			}
+			pChunk->influence[m_FrontBuffer].swap(influence);
+		}
+
+		m_NrOfLayers = nrOfLayers;
+
+		// Rebuilt right away, the pyramid queries find nothing while the buffer is dirty. One that was dirty already is left to
+		// the next propagation, like after any edit of the graph
+		if (!m_IsBufferDirty)
+			InitializeBuffer();
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	float InfluenceMap<T_GraphType, T_InfluencePolicy>::CalculatePropagatedInfluence(int idx, int layer) const
+	{
+		//check the influence of each neighboring node
+		float highestInfluence{ 0 };
+		ForEachNeighbor(idx, [&](int neighborIdx, float cost)
+			{
+				const float newInfluence{ GetInfluence(neighborIdx, layer) * std::exp(-cost * GetDecay(layer)) };
 
 				if (abs(newInfluence) > abs(highestInfluence))
 				{
 					highestInfluence = newInfluence;
 				}
+			});
+
+		return Lerp(highestInfluence, GetInfluence(idx, layer), GetMomentum(layer));
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::MarkCellsDirty(int minCol, int minRow, int maxCol, int maxRow)
+	{
+		if (m_IsBufferDirty)
+			return; // everything is marked when the buffer gets rebuilt
+
+		// the neighbours of the changed cells read them, so grow the range by one cell before converting to tiles
+		const int minTileCol{ Clamp(minCol - 1, 0, GetColumns() - 1) / m_TileSize };
+		const int minTileRow{ Clamp(minRow - 1, 0, GetRows() - 1) / m_TileSize };
+		const int maxTileCol{ Clamp(maxCol + 1, 0, GetColumns() - 1) / m_TileSize };
+		const int maxTileRow{ Clamp(maxRow + 1, 0, GetRows() - 1) / m_TileSize };
+
+		for (int tileRow = minTileRow; tileRow <= maxTileRow; ++tileRow)
+		{
+			for (int tileCol = minTileCol; tileCol <= maxTileCol; ++tileCol)
+			{
+				MarkTileDirty(tileRow * m_TileColumns + tileCol);
 			}
+		}
+	}
 
-			m_InfluenceDoubleBuffer.emplace_back(Lerp(highestInfluence, node->GetInfluence(), GetMomentum()));
-		} 
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::MarkTileDirty(int tileIdx)
+	{
+		if (m_IsTileDirty[tileIdx])
+			return;
 
+		m_IsTileDirty[tileIdx] = 1;
+		m_DirtyTiles.push_back(tileIdx);
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::CopyTileToBuffer(int tileIdx)
+	{
+		const int beginCol{ (tileIdx % m_TileColumns) * m_TileSize };
+		const int endCol{ min(beginCol + m_TileSize, GetColumns()) };
+		const int beginRow{ (tileIdx / m_TileColumns) * m_TileSize };
+		const int endRow{ min(beginRow + m_TileSize, GetRows()) };
+
+		Chunk* pChunk{ m_Chunks[GetChunkIdx(beginCol, beginRow)].get() };
+		if (!pChunk)
+			return;
 
-		//copy influences from buffer to the nodes
-		for (size_t i = 0; i < m_InfluenceDoubleBuffer.size(); i++)
+		const int tileWidth{ (endCol - beginCol) * m_NrOfLayers };
+		for (int r = beginRow; r < endRow; ++r)
 		{
-			GetNode(i)->SetInfluence(m_InfluenceDoubleBuffer[i]);
+			const int begin{ GetChunkOffset(beginCol, r) * m_NrOfLayers };
+			std::copy(pChunk->influence[m_FrontBuffer].begin() + begin, pChunk->influence[m_FrontBuffer].begin() + begin + tileWidth,
+				pChunk->influence[m_FrontBuffer ^ 1].begin() + begin);
 		}
 	}
 
-	template <class T_GraphType>
-	void InfluenceMap<T_GraphType>::PropagateInfluence(float deltaTime, const Vector2& pos, float radius)
+	// Copies the front buffer influence of cells [beginCol - 1, endCol] of the row, the columns of the tile plus one on either side
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::GatherTileRow(int row, int beginCol, int endCol, Value* pOut) const
 	{
-		//make sure this function only executes once every interval
-		m_TimeSinceLastPropagation += deltaTime;
-		if (m_TimeSinceLastPropagation < m_PropagationInterval) return;
-		m_TimeSinceLastPropagation = 0;
+		const Value* pLeft{ GetCellInfluence(beginCol - 1, row) };
+		pOut = std::copy(pLeft, pLeft + m_NrOfLayers, pOut);
+
+		// the columns of the tile all sit in the same chunk
+		const Value* pTile{ GetCellInfluence(beginCol, row) };
+		const int tileWidth{ (endCol - beginCol) * m_NrOfLayers };
+		if (pTile == m_ZeroCell)
+			pOut = std::fill_n(pOut, tileWidth, Value{});
+		else
+			pOut = std::copy(pTile, pTile + tileWidth, pOut);
+
+		const Value* pRight{ GetCellInfluence(endCol, row) };
+		std::copy(pRight, pRight + m_NrOfLayers, pOut);
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	bool InfluenceMap<T_GraphType, T_InfluencePolicy>::PropagateTile(int tileIdx)
+	{
+		const int columns{ GetColumns() };
+		const int beginCol{ (tileIdx % m_TileColumns) * m_TileSize };
+		const int endCol{ min(beginCol + m_TileSize, columns) };
+		const int beginRow{ (tileIdx / m_TileColumns) * m_TileSize };
+		const int endRow{ min(beginRow + m_TileSize, GetRows()) };
 
-		auto nodesInRange{ GetNodeIndicesInRadius(pos, radius) };
+		// the chunk was made when the sweep started, workers never allocate
+		Chunk& chunk{ *m_Chunks[GetChunkIdx(beginCol, beginRow)] };
+		const Value* pFront{ chunk.influence[m_FrontBuffer].data() };
+		Value* pBack{ chunk.influence[m_FrontBuffer ^ 1].data() };
+		const int tileWidth{ (endCol - beginCol) * m_NrOfLayers };
 
-		//go over all the nodes
-		for (int idx : nodesInRange)
+		if (IsUsingGridKernel())
 		{
-			const auto& node{ GetNode(idx) };
+			// The stencil runs on a copy of the tile with a border of one cell, taken from the neighbouring chunks.
+			// Cells outside the grid read as zero, which never wins, so the border of the grid needs no special case.
+			const int haloColumns{ endCol - beginCol + 2 };
+			const int haloRowSize{ haloColumns * m_NrOfLayers };
+			Value halo[(m_TileSize + 2) * (m_TileSize + 2) * InfluenceKernels::MaxLayers];
+			Value propagatedRow[(m_TileSize + 2) * InfluenceKernels::MaxLayers];
 
-			//get each neighbor node, check their influence
-			const auto connections{ GetNodeConnections(node->GetIndex()) };
+			for (int r = beginRow - 1; r <= endRow; ++r)
+				GatherTileRow(r, beginCol, endCol, halo + (r - beginRow + 1) * haloRowSize);
 
-			//check the influence of each neighboring node
-			float highestInfluence{ 0 };
-			for (const auto& connection : connections)
+			for (int r = beginRow; r < endRow; ++r)
 			{
-				const float newInfluence{ GetNode(connection->GetTo())->GetInfluence() * std::expf(-connection->GetCost() * GetDecay()) };
+				const Value* pMid{ halo + (r - beginRow + 1) * haloRowSize };
+				InfluenceKernels::PropagateRow(pMid - haloRowSize, pMid, pMid + haloRowSize, propagatedRow,
+					haloColumns, 1, haloColumns - 1, m_LayerFactors);
 
-				if (abs(newInfluence) > abs(highestInfluence))
+				std::copy(propagatedRow + m_NrOfLayers, propagatedRow + m_NrOfLayers + tileWidth, pBack + GetChunkOffset(beginCol, r) * m_NrOfLayers);
+			}
+		}
+		else
+		{
+			// assumes the connections only link adjacent cells, like the ones the grid creates
+			for (int r = beginRow; r < endRow; ++r)
+			{
+				for (int c = beginCol; c < endCol; ++c)
 				{
-					highestInfluence = newInfluence;
+					const int idx{ r * columns + c };
+					for (int layer = 0; layer < m_NrOfLayers; ++layer)
+					{
+						const int i{ GetChunkOffset(c, r) * m_NrOfLayers + layer };
+						pBack[i] = IsNodeValid(idx) ? T_InfluencePolicy::FromFloat(CalculatePropagatedInfluence(idx, layer)) : pFront[i];
+					}
+				}
+			}
+		}
+
+		//check if any cell of the tile changed enough to keep it (and its neighbours) awake
+		for (int r = beginRow; r < endRow; ++r)
+		{
+			const int begin{ GetChunkOffset(beginCol, r) * m_NrOfLayers };
+			for (int i = begin; i < begin + tileWidth; ++i)
+			{
+				if (abs(T_InfluencePolicy::ToFloat(pBack[i]) - T_InfluencePolicy::ToFloat(pFront[i])) > m_ChangeThreshold)
+					return true;
+			}
+		}
+
+		return false;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::BeginSweep(int minCol, int minRow, int maxCol, int maxRow)
+	{
+		const int minTileCol{ minCol / m_TileSize };
+		const int minTileRow{ minRow / m_TileSize };
+		const int maxTileCol{ maxCol / m_TileSize };
+		const int maxTileRow{ maxRow / m_TileSize };
+
+		// the decay only changes the factors, so they are worked out once per propagation instead of per cell
+		m_LayerFactors.nrOfLayers = m_NrOfLayers;
+		for (int layer = 0; layer < m_NrOfLayers; ++layer)
+		{
+			m_LayerFactors.SetLayer(layer,
+				std::exp(-GetDefaultCostStraight() * GetDecay(layer)),
+				IsConnectedDiagonally() ? std::exp(-GetDefaultCostDiagonal() * GetDecay(layer)) : 0.f,
+				GetMomentum(layer));
+		}
+
+		// tiles marked from here on are dirty for the next propagation
+		m_TilesToProcess.swap(m_DirtyTiles);
+		m_DirtyTiles.clear();
+		for (int tileIdx : m_TilesToProcess)
+		{
+			m_IsTileDirty[tileIdx] = 0;
+		}
+
+		m_TilesInRange.clear();
+		for (int tileIdx : m_TilesToProcess)
+		{
+			const int tileCol{ tileIdx % m_TileColumns };
+			const int tileRow{ tileIdx / m_TileColumns };
+
+			if (tileCol < minTileCol || tileCol > maxTileCol || tileRow < minTileRow || tileRow > maxTileRow)
+			{
+				// out of range, keep its current values through the swap and try again later
+				CopyTileToBuffer(tileIdx);
+				MarkTileDirty(tileIdx);
+			}
+			else
+			{
+				// a tile can only pick up influence from its neighbours, so its chunk is made here rather than on a worker
+				TouchChunk(GetChunkIdx(tileCol * m_TileSize, tileRow * m_TileSize));
+				m_TilesInRange.push_back(tileIdx);
+			}
+		}
+
+		m_HasTileChanged.resize(m_TilesInRange.size());
+		m_SweepCursor = 0;
+		m_SweepDuration = 0.f;
+		m_IsSweepActive = true;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::PropagateTiles(int begin, int end)
+	{
+		// Tiles only read the front buffer and only write their own cells in the back buffer, so they can run in any order.
+		// Settled tiles keep their exact values so both buffers agree and the tile can sleep.
+		const auto propagateTiles = [this](int first, int last)
+		{
+			for (int i = first; i < last; ++i)
+			{
+				m_HasTileChanged[i] = PropagateTile(m_TilesInRange[i]);
+				if (!m_HasTileChanged[i])
+					CopyTileToBuffer(m_TilesInRange[i]);
+			}
+		};
+
+		if (m_pThreadPool && end - begin >= m_MinTilesPerThread * 2)
+		{
+			// the stored connections get walked without the stencil, their copy has to exist before the workers read it.
+			// Checked every batch, the graph can be edited between the frames of a budgeted sweep
+			if (!IsUsingGridKernel() && !IsUsingImplicitConnections())
+				EnsureAdjacency();
+
+			m_pThreadPool->ParallelFor(end - begin, max(m_TileColumns, m_MinTilesPerThread),
+				[&](int chunkBegin, int chunkEnd) { propagateTiles(begin + chunkBegin, begin + chunkEnd); });
+		}
+		else
+		{
+			propagateTiles(begin, end);
+		}
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::FinishSweep()
+	{
+		// Marking happens afterwards in list order, so the next dirty set doesn't depend on the number of threads
+		for (int i = 0; i < static_cast<int>(m_TilesInRange.size()); ++i)
+		{
+			if (!m_HasTileChanged[i])
+				continue;
+
+			const int beginCol{ (m_TilesInRange[i] % m_TileColumns) * m_TileSize };
+			const int beginRow{ (m_TilesInRange[i] / m_TileColumns) * m_TileSize };
+			MarkCellsDirty(beginCol, beginRow, beginCol + m_TileSize - 1, beginRow + m_TileSize - 1);
+			MarkPyramidTileDirty(m_TilesInRange[i]);
+		}
+
+		m_FrontBuffer ^= 1;
+		m_LastSweepDuration = m_SweepDuration;
+		m_IsSweepActive = false;
+
+		// only the tiles that changed can hold cells that moved past the threshold
+		if (IsWatchingChanges())
+		{
+			const int columns{ GetColumns() };
+			for (int i = 0; i < static_cast<int>(m_TilesInRange.size()); ++i)
+			{
+				if (!m_HasTileChanged[i])
+					continue;
+
+				const int beginCol{ (m_TilesInRange[i] % m_TileColumns) * m_TileSize };
+				const int beginRow{ (m_TilesInRange[i] / m_TileColumns) * m_TileSize };
+				for (int row = beginRow; row < min(beginRow + m_TileSize, GetRows()); ++row)
+				{
+					for (int col = beginCol; col < min(beginCol + m_TileSize, columns); ++col)
+						CheckForChange(row * columns + col);
 				}
 			}
+		}
+	}
 
-			m_InfluenceDoubleBuffer[idx]=(Lerp(highestInfluence, node->GetInfluence(), GetMomentum()));
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::ContinueSweep(float deltaTime)
+	{
+		const int nrOfTiles{ static_cast<int>(m_TilesInRange.size()) };
+		if (m_PropagationBudget <= 0.f)
+		{
+			PropagateTiles(m_SweepCursor, nrOfTiles);
+			m_SweepCursor = nrOfTiles;
+			FinishSweep();
+			return;
 		}
-	
 
+		// Keep pace so the sweep is done by the time the next one should start, even if that means going over budget
+		const float pace{ min((m_TimeSinceLastPropagation + deltaTime) / m_PropagationInterval, 1.f) };
+		const int paceCursor{ static_cast<int>(std::ceil(pace * nrOfTiles)) };
 
-		//copy influences from buffer to the nodes
-		for (size_t i = 0; i < m_InfluenceDoubleBuffer.size(); i++)
+		// Check the clock per batch, big enough to keep every thread busy
+		const int batchSize{ static_cast<int>(GetNrOfPropagationThreads()) * m_MinTilesPerThread };
+		const auto start{ std::chrono::steady_clock::now() };
+		int budgetCursor{ -1 };
+		while (m_SweepCursor < nrOfTiles)
+		{
+			const int end{ min(m_SweepCursor + batchSize, nrOfTiles) };
+			PropagateTiles(m_SweepCursor, end);
+			m_SweepCursor = end;
+
+			const std::chrono::duration<float, std::micro> elapsed{ std::chrono::steady_clock::now() - start };
+			if (budgetCursor < 0 && elapsed.count() >= m_PropagationBudget)
+				budgetCursor = m_SweepCursor;
+
+			if (budgetCursor >= 0 && m_SweepCursor >= paceCursor)
+				break;
+		}
+
+		// the part of the sweep that had to be done over budget
+		m_SweepLag = budgetCursor >= 0 ? static_cast<float>(m_SweepCursor - budgetCursor) / nrOfTiles : 0.f;
+		if (m_SweepLag > 0.f)
+			++m_NrOfOverBudgetFrames;
+
+		if (m_SweepCursor == nrOfTiles)
+			FinishSweep();
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::PropagateDirtyTiles(float deltaTime, int minCol, int minRow, int maxCol, int maxRow)
+	{
+		//make sure a new sweep only starts once every interval
+		m_TimeSinceLastPropagation += deltaTime;
+		if (m_IsSweepActive)
+		{
+			m_SweepDuration += deltaTime;
+		}
+		else
 		{
-			GetNode(i)->SetInfluence(m_InfluenceDoubleBuffer[i]);
+			if (m_TimeSinceLastPropagation < m_PropagationInterval) return;
+			m_TimeSinceLastPropagation = 0;
+			BeginSweep(minCol, minRow, maxCol, maxRow);
 		}
+
+		ContinueSweep(deltaTime);
 	}
 
-	template <class T_GraphType>
-	inline void InfluenceMap<T_GraphType>::SetInfluenceAtPosition(Elite::Vector2 pos, float influence)
+	template <class T_GraphType, class T_InfluencePolicy>
+	float InfluenceMap<T_GraphType, T_InfluencePolicy>::GetSweepProgress() const
 	{
-		auto idx = GetNodeIdxAtWorldPos(pos);
-		if (IsNodeValid(idx))
-			GetNode(idx)->SetInfluence(influence);
+		if (!m_IsSweepActive || m_TilesInRange.empty())
+			return 1.f;
+
+		return static_cast<float>(m_SweepCursor) / m_TilesInRange.size();
 	}
 
-	template <class T_GraphType>
-	inline void InfluenceMap<T_GraphType>::SetInfluenceAtPosition(int idx, float influence)
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::SetNrOfPropagationThreads(unsigned int nrOfThreads)
 	{
-		if (IsNodeValid(idx))
-			GetNode(idx)->SetInfluence(influence);
+		if (nrOfThreads == GetNrOfPropagationThreads())
+			return;
+
+		m_pThreadPool.reset(nrOfThreads > 1 ? new ThreadPool(nrOfThreads - 1) : nullptr);
 	}
 
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::PropagateInfluence(float deltaTime)
+	{
+		if (m_IsBufferDirty)
+			InitializeBuffer();
+
+		PropagateDirtyTiles(deltaTime, 0, 0, GetColumns() - 1, GetRows() - 1);
+	}
 
-	template <class T_GraphType>
-	inline void InfluenceMap<T_GraphType>::SetScannedAtPosition(int idx, bool scanned)
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::PropagateInfluence(float deltaTime, const Vector2& pos, float radius)
 	{
-		if (IsNodeValid(idx))
-			GetNode(idx)->SetScanned(scanned);
+		if (m_IsBufferDirty)
+			InitializeBuffer();
+
+		//only the dirty tiles overlapping the square around the radius are propagated, a sweep keeps the range it started with
+		int minCol, minRow, maxCol, maxRow;
+		if (!GetCellRangeInRect(pos, { radius * 2.f, radius * 2.f }, minCol, minRow, maxCol, maxRow) && !m_IsSweepActive)
+			return;
+
+		PropagateDirtyTiles(deltaTime, minCol, minRow, maxCol, maxRow);
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	inline void InfluenceMap<T_GraphType, T_InfluencePolicy>::SetInfluenceAtPosition(Elite::Vector2 pos, float influence, int layer)
+	{
+		SetInfluenceAtPosition(GetNodeIdxAtWorldPos(pos), influence, layer);
 	}
 
-	template <class T_GraphType>
-	inline void InfluenceMap<T_GraphType>::SetScannedAtPosition(const std::unordered_set<int>& indices, bool scanned)
+	template <class T_GraphType, class T_InfluencePolicy>
+	inline void InfluenceMap<T_GraphType, T_InfluencePolicy>::SetInfluenceAtPosition(int idx, float influence, int layer)
+	{
+		if (!IsBufferValid(idx))
+			return;
+
+		const int col{ idx % GetColumns() };
+		const int row{ idx / GetColumns() };
+		if (influence == 0.f && !m_Chunks[GetChunkIdx(col, row)])
+			return; // nothing to clear
+
+		// written to both buffers, so it also sticks when a budgeted sweep already passed this cell
+		Chunk& chunk{ TouchChunk(GetChunkIdx(col, row)) };
+		const int i{ GetChunkOffset(col, row) * m_NrOfLayers + layer };
+		chunk.influence[m_FrontBuffer][i] = T_InfluencePolicy::FromFloat(influence);
+		if (!m_IsBufferDirty)
+			chunk.influence[m_FrontBuffer ^ 1][i] = chunk.influence[m_FrontBuffer][i];
+		MarkCellsDirty(col, row, col, row);
+		MarkPyramidTileDirty((row / m_TileSize) * m_TileColumns + col / m_TileSize);
+		if (layer == m_WatchedLayer)
+			CheckForChange(idx);
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	inline float InfluenceMap<T_GraphType, T_InfluencePolicy>::GetInfluence(int idx, const std::vector<float>& layerWeights) const
+	{
+		const Value* pCell{ GetCellInfluence(idx % GetColumns(), idx / GetColumns()) };
+
+		float influence{ 0 };
+		for (int layer = 0; layer < m_NrOfLayers && layer < static_cast<int>(layerWeights.size()); ++layer)
+		{
+			influence += layerWeights[layer] * T_InfluencePolicy::ToFloat(pCell[layer]);
+		}
+
+		return influence;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	inline float InfluenceMap<T_GraphType, T_InfluencePolicy>::GetInfluenceAtPosition(const Elite::Vector2& pos, int layer) const
+	{
+		const int idx{ GetNodeIdxAtWorldPos(pos) };
+		return IsBufferValid(idx) ? GetInfluence(idx, layer) : 0.f;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	inline float InfluenceMap<T_GraphType, T_InfluencePolicy>::GetInfluenceAtPosition(const Elite::Vector2& pos, const std::vector<float>& layerWeights) const
+	{
+		const int idx{ GetNodeIdxAtWorldPos(pos) };
+		return IsBufferValid(idx) ? GetInfluence(idx, layerWeights) : 0.f;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	inline bool InfluenceMap<T_GraphType, T_InfluencePolicy>::IsScanned(int idx) const
+	{
+		const int col{ idx % GetColumns() };
+		return (m_ScannedBits[(idx / GetColumns()) * m_ScannedWordsPerRow + col / 64] >> (col % 64)) & 1;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	inline void InfluenceMap<T_GraphType, T_InfluencePolicy>::SetScannedAtPosition(int idx, bool scanned)
+	{
+		if (IsBufferValid(idx))
+			SetScannedInRow(idx / GetColumns(), idx % GetColumns(), idx % GetColumns(), scanned);
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	inline void InfluenceMap<T_GraphType, T_InfluencePolicy>::SetScannedAtPosition(const std::unordered_set<int>& indices, bool scanned)
 	{
 		for (const auto& idx : indices)
 		{
@@ -164,24 +926,868 @@ namespace Elite
 		}
 	}
 
-	template <class T_GraphType>
-	inline void InfluenceMap<T_GraphType>::SetInfluenceAtPosition(const std::unordered_set<int>& indices, float influence)
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::SetScannedInRect(const Elite::Vector2& pos, const Elite::Vector2& size, bool scanned)
+	{
+		int minCol, minRow, maxCol, maxRow;
+		if (m_ScannedBits.empty() || !GetNodeRangeInRect(pos, size, minCol, minRow, maxCol, maxRow))
+			return;
+
+		for (int row = minRow; row <= maxRow; ++row)
+			SetScannedInRow(row, minCol, maxCol, scanned);
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::SetScannedInRadius(const Elite::Vector2& pos, float radius, bool scanned)
+	{
+		int minCol, minRow, maxCol, maxRow;
+		if (m_ScannedBits.empty() || !GetNodeRangeInRect(pos, { radius * 2, radius * 2 }, minCol, minRow, maxCol, maxRow))
+			return;
+
+		for (int row = minRow; row <= maxRow; ++row)
+		{
+			if (GetNodeSpanInRadius(pos, radius, row, minCol, maxCol))
+				SetScannedInRow(row, minCol, maxCol, scanned);
+		}
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::SetScannedInRow(int row, int minCol, int maxCol, bool scanned)
+	{
+		uint64_t* pRow{ m_ScannedBits.data() + row * m_ScannedWordsPerRow };
+		const uint64_t* pTarget{ m_ScanTargetBits.data() + row * m_ScannedWordsPerRow };
+		bool hasChanged{ false };
+		for (int word = minCol / 64; word <= maxCol / 64; ++word)
+		{
+			const uint64_t mask{ GetWordMask(word, minCol, maxCol) };
+			const uint64_t oldBits{ pRow[word] };
+			if (scanned)
+				pRow[word] |= mask;
+			else
+				pRow[word] &= ~mask;
+			hasChanged = hasChanged || ((pRow[word] ^ oldBits) & pTarget[word]) != 0;
+		}
+
+		// rescanning cells that already were, or cells outside the target area, doesn't touch the distance transform
+		if (hasChanged)
+			MarkUnscannedRowDirty(row);
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::MarkUnscannedRowDirty(int row)
+	{
+		m_UnscannedDirtyMinRow = min(m_UnscannedDirtyMinRow, row);
+		m_UnscannedDirtyMaxRow = max(m_UnscannedDirtyMaxRow, row);
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::SetScanTargetArea(const std::unordered_set<int>& area)
+	{
+		if (m_ScannedBits.empty())
+			return;
+
+		m_NewScanTargetBits.assign(m_ScanTargetBits.size(), 0);
+		for (int idx : area)
+		{
+			if (IsBufferValid(idx))
+				m_NewScanTargetBits[(idx / GetColumns()) * m_ScannedWordsPerRow + (idx % GetColumns()) / 64] |= uint64_t{ 1 } << (idx % GetColumns() % 64);
+		}
+
+		for (int row = 0; row < m_BufferRows; ++row)
+		{
+			const size_t first{ static_cast<size_t>(row) * m_ScannedWordsPerRow };
+			if (!std::equal(m_NewScanTargetBits.begin() + first, m_NewScanTargetBits.begin() + first + m_ScannedWordsPerRow, m_ScanTargetBits.begin() + first))
+				MarkUnscannedRowDirty(row);
+		}
+		m_ScanTargetBits.swap(m_NewScanTargetBits);
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::ResetScanTargetArea()
+	{
+		if (std::any_of(m_ScanTargetBits.begin(), m_ScanTargetBits.end(), [](uint64_t bits) { return bits != ~uint64_t{ 0 }; }))
+		{
+			std::fill(m_ScanTargetBits.begin(), m_ScanTargetBits.end(), ~uint64_t{ 0 });
+			m_UnscannedDirtyMinRow = 0;
+			m_UnscannedDirtyMaxRow = m_BufferRows - 1;
+		}
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	bool InfluenceMap<T_GraphType, T_InfluencePolicy>::IsScanTargetAreaScanned() const
+	{
+		const int lastCol{ m_BufferColumns - 1 };
+		for (int row = 0; row < m_BufferRows; ++row)
+		{
+			const uint64_t* pRow{ m_ScannedBits.data() + row * m_ScannedWordsPerRow };
+			const uint64_t* pTarget{ m_ScanTargetBits.data() + row * m_ScannedWordsPerRow };
+			for (int word = 0; word < m_ScannedWordsPerRow; ++word)
+			{
+				if ((pTarget[word] & ~pRow[word] & GetWordMask(word, 0, lastCol)) != 0)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// The bits of the given word that fall within columns [minCol, maxCol]
+	template <class T_GraphType, class T_InfluencePolicy>
+	uint64_t InfluenceMap<T_GraphType, T_InfluencePolicy>::GetWordMask(int word, int minCol, int maxCol)
+	{
+		uint64_t mask{ ~uint64_t{ 0 } };
+		if (word == minCol / 64)
+			mask &= ~uint64_t{ 0 } << (minCol % 64);
+		if (word == maxCol / 64)
+			mask &= ~uint64_t{ 0 } >> (63 - maxCol % 64);
+		return mask;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	inline void InfluenceMap<T_GraphType, T_InfluencePolicy>::SetInfluenceAtPosition(const std::unordered_set<int>& indices, float influence, int layer)
 	{
 		for (const auto& idx : indices)
 		{
-			SetInfluenceAtPosition(idx, influence);
+			SetInfluenceAtPosition(idx, influence, layer);
 		}
 	}
 
-	template<class T_GraphType>
-	inline void InfluenceMap<T_GraphType>::SetNodeColorsBasedOnInfluence()
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::UpdateUnscannedDistances() const
+	{
+		const int columns{ GetColumns() };
+		const int rows{ GetRows() };
+		if (m_UnscannedDirtyMinRow > m_UnscannedDirtyMaxRow || m_ScannedBits.empty() || columns != m_BufferColumns || rows != m_BufferRows)
+			return;
+
+		if (m_UnscannedDistance.size() != static_cast<size_t>(columns) * rows)
+		{
+			m_RowUnscannedColumn.assign(static_cast<size_t>(columns) * rows, -1);
+			m_UnscannedDistance.assign(static_cast<size_t>(columns) * rows, FLT_MAX);
+			m_NearestUnscanned.assign(static_cast<size_t>(columns) * rows, invalid_node_index);
+			m_EnvelopeRows.resize(max(columns, rows));
+			m_EnvelopeBounds.resize(rows + 1);
+			m_UnscannedDirtyMinRow = 0;
+			m_UnscannedDirtyMaxRow = rows - 1;
+		}
+
+		// Row pass, the nearest unscanned column on either side in two sweeps. Only the columns where the answer
+		// moved in some row need the column pass, a scan seldom reaches further than the view.
+		int minChangedCol{ columns };
+		int maxChangedCol{ -1 };
+		int* pLeftUnscanned{ m_EnvelopeRows.data() };
+		for (int row = m_UnscannedDirtyMinRow; row <= min(m_UnscannedDirtyMaxRow, rows - 1); ++row)
+		{
+			const uint64_t* pBits{ m_ScannedBits.data() + row * m_ScannedWordsPerRow };
+			const uint64_t* pTarget{ m_ScanTargetBits.data() + row * m_ScannedWordsPerRow };
+			const auto isUnscanned = [pBits, pTarget](int col) { return (((pTarget[col / 64] & ~pBits[col / 64]) >> (col % 64)) & 1) != 0; };
+
+			int leftUnscanned{ -1 };
+			for (int col = 0; col < columns; ++col)
+			{
+				if (isUnscanned(col))
+					leftUnscanned = col;
+				pLeftUnscanned[col] = leftUnscanned;
+			}
+
+			int* pNearest{ m_RowUnscannedColumn.data() + row * columns };
+			int rightUnscanned{ -1 };
+			for (int col = columns - 1; col >= 0; --col)
+			{
+				if (isUnscanned(col))
+					rightUnscanned = col;
+
+				int nearest{ pLeftUnscanned[col] };
+				if (rightUnscanned >= 0 && (nearest < 0 || rightUnscanned - col < col - nearest))
+					nearest = rightUnscanned;
+
+				if (pNearest[col] != nearest)
+				{
+					pNearest[col] = nearest;
+					minChangedCol = min(minChangedCol, col);
+					maxChangedCol = max(maxChangedCol, col);
+				}
+			}
+		}
+
+		for (int col = minChangedCol; col <= maxChangedCol; ++col)
+			UpdateUnscannedColumn(col);
+
+		m_UnscannedDirtyMinRow = INT_MAX;
+		m_UnscannedDirtyMaxRow = -1;
+	}
+
+	// Felzenszwalb and Huttenlocher's lower envelope of the parabolas (row - r)^2 + f(r), f(r) the squared distance to
+	// the nearest unscanned cell within row r. Rows without one are left out rather than given an infinite parabola.
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::UpdateUnscannedColumn(int col) const
+	{
+		const int columns{ GetColumns() };
+		const int rows{ GetRows() };
+		const auto rowDistance = [this, columns, col](int row)
+		{
+			const float offset{ static_cast<float>(col - m_RowUnscannedColumn[row * columns + col]) };
+			return offset * offset;
+		};
+
+		int* pRows{ m_EnvelopeRows.data() }; // the rows whose parabola is part of the envelope
+		float* pBounds{ m_EnvelopeBounds.data() }; // pRows[k] is the lowest between pBounds[k] and pBounds[k + 1]
+		int k{ -1 };
+		for (int row = 0; row < rows; ++row)
+		{
+			if (m_RowUnscannedColumn[row * columns + col] < 0)
+				continue;
+
+			const float value{ rowDistance(row) + static_cast<float>(row * row) };
+			float intersection{ -FLT_MAX };
+			while (k >= 0)
+			{
+				const int other{ pRows[k] };
+				intersection = (value - rowDistance(other) - static_cast<float>(other * other)) / (2.f * (row - other));
+				if (intersection > pBounds[k])
+					break;
+				--k;
+			}
+
+			++k;
+			pRows[k] = row;
+			pBounds[k] = k == 0 ? -FLT_MAX : intersection;
+			pBounds[k + 1] = FLT_MAX;
+		}
+
+		for (int row = 0, i = 0; row < rows; ++row)
+		{
+			const int idx{ row * columns + col };
+			if (k < 0)
+			{
+				m_UnscannedDistance[idx] = FLT_MAX;
+				m_NearestUnscanned[idx] = invalid_node_index;
+				continue;
+			}
+
+			while (pBounds[i + 1] < static_cast<float>(row))
+				++i;
+
+			const int nearestRow{ pRows[i] };
+			m_UnscannedDistance[idx] = static_cast<float>((row - nearestRow) * (row - nearestRow)) + rowDistance(nearestRow);
+			m_NearestUnscanned[idx] = nearestRow * columns + m_RowUnscannedColumn[nearestRow * columns + col];
+		}
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	int InfluenceMap<T_GraphType, T_InfluencePolicy>::GetNearestUnscannedCell(int idx) const
+	{
+		if (!IsBufferValid(idx))
+			return invalid_node_index;
+
+		UpdateUnscannedDistances();
+		return idx < static_cast<int>(m_NearestUnscanned.size()) ? m_NearestUnscanned[idx] : invalid_node_index;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	float InfluenceMap<T_GraphType, T_InfluencePolicy>::GetDistanceToUnscanned(int idx) const
+	{
+		if (!IsBufferValid(idx))
+			return FLT_MAX;
+
+		UpdateUnscannedDistances();
+		return idx < static_cast<int>(m_UnscannedDistance.size()) && m_UnscannedDistance[idx] != FLT_MAX ? sqrtf(m_UnscannedDistance[idx]) : FLT_MAX;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	Elite::Vector2 InfluenceMap<T_GraphType, T_InfluencePolicy>::GetUnscannedGradient(const Elite::Vector2& pos) const
+	{
+		const int idx{ GetNodeIdxAtWorldPos(pos) };
+		const int nearestIdx{ GetNearestUnscannedCell(idx) };
+		if (nearestIdx == invalid_node_index || nearestIdx == idx)
+			return {};
+
+		return (GetNodeWorldPos(nearestIdx) - pos).GetNormalized();
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	int InfluenceMap<T_GraphType, T_InfluencePolicy>::GetNrOfScannedCells(int minCol, int minRow, int maxCol, int maxRow) const
+	{
+		if (m_ScannedBits.empty())
+			return 0;
+
+		int nrOfScannedCells{ 0 };
+		for (int row = minRow; row <= maxRow; ++row)
+		{
+			const uint64_t* pRow{ m_ScannedBits.data() + row * m_ScannedWordsPerRow };
+			for (int word = minCol / 64; word <= maxCol / 64; ++word)
+				nrOfScannedCells += InfluenceKernels::CountBits(pRow[word] & GetWordMask(word, minCol, maxCol));
+		}
+
+		return nrOfScannedCells;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	float InfluenceMap<T_GraphType, T_InfluencePolicy>::GetInfluenceSum(int minCol, int minRow, int maxCol, int maxRow, int layer) const
+	{
+		const CellArea area{ minCol, minRow, maxCol, maxRow, false };
+		return static_cast<float>(GetInfluenceSum(area, layer));
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	float InfluenceMap<T_GraphType, T_InfluencePolicy>::GetScannedRatioInRect(const Elite::Vector2& pos, const Elite::Vector2& size) const
+	{
+		int minCol, minRow, maxCol, maxRow;
+		if (!GetNodeRangeInRect(pos, size, minCol, minRow, maxCol, maxRow))
+			return 0.f;
+
+		const int nrOfCells{ (maxCol - minCol + 1) * (maxRow - minRow + 1) };
+		return static_cast<float>(GetNrOfScannedCells(minCol, minRow, maxCol, maxRow)) / nrOfCells;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	float InfluenceMap<T_GraphType, T_InfluencePolicy>::GetAverageInfluenceInRect(const Elite::Vector2& pos, const Elite::Vector2& size, int layer) const
+	{
+		int minCol, minRow, maxCol, maxRow;
+		if (!GetNodeRangeInRect(pos, size, minCol, minRow, maxCol, maxRow))
+			return 0.f;
+
+		const int nrOfCells{ (maxCol - minCol + 1) * (maxRow - minRow + 1) };
+		return GetInfluenceSum(minCol, minRow, maxCol, maxRow, layer) / nrOfCells;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::InitializePyramid()
+	{
+		static_assert(m_PyramidBranching * m_PyramidBranching == m_TileSize, "the top level blocks of the pyramid have to be the tiles");
+
+		m_Pyramid.clear();
+		for (int blockSize = m_PyramidBranching; blockSize <= m_TileSize; blockSize *= m_PyramidBranching)
+		{
+			InfluenceBlockLevel level{};
+			level.blockSize = blockSize;
+			level.columns = (GetColumns() + blockSize - 1) / blockSize;
+			level.rows = (GetRows() + blockSize - 1) / blockSize;
+			level.lowest.assign(level.columns * level.rows * m_NrOfLayers, 0.f);
+			level.highest.assign(level.columns * level.rows * m_NrOfLayers, 0.f);
+			level.sum.assign(level.columns * level.rows * m_NrOfLayers, 0.f);
+			m_Pyramid.push_back(std::move(level));
+		}
+
+		m_IsPyramidTileDirty.assign(m_TileColumns * m_TileRows, 1);
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::UpdatePyramidTile(int tileIdx) const
+	{
+		const int columns{ GetColumns() };
+		const int beginCol{ (tileIdx % m_TileColumns) * m_TileSize };
+		const int lastCol{ min(beginCol + m_TileSize, columns) - 1 };
+		const int beginRow{ (tileIdx / m_TileColumns) * m_TileSize };
+		const int lastRow{ min(beginRow + m_TileSize, GetRows()) - 1 };
+
+		// bottom up, the finest level reads the cells and every other level the blocks of the level below it
+		for (int levelIdx = 0; levelIdx < static_cast<int>(m_Pyramid.size()); ++levelIdx)
+		{
+			InfluenceBlockLevel& level{ m_Pyramid[levelIdx] };
+			for (int blockRow = beginRow / level.blockSize; blockRow <= lastRow / level.blockSize; ++blockRow)
+			{
+				for (int blockCol = beginCol / level.blockSize; blockCol <= lastCol / level.blockSize; ++blockCol)
+				{
+					float lowest[InfluenceKernels::MaxLayers];
+					float highest[InfluenceKernels::MaxLayers];
+					float sum[InfluenceKernels::MaxLayers];
+					std::fill(lowest, lowest + m_NrOfLayers, FLT_MAX);
+					std::fill(highest, highest + m_NrOfLayers, -FLT_MAX);
+					std::fill(sum, sum + m_NrOfLayers, 0.f);
+
+					if (levelIdx == 0)
+					{
+						const int endRow{ min((blockRow + 1) * level.blockSize, GetRows()) };
+						const int endCol{ min((blockCol + 1) * level.blockSize, columns) };
+						for (int row = blockRow * level.blockSize; row < endRow; ++row)
+						{
+							for (int col = blockCol * level.blockSize; col < endCol; ++col)
+							{
+								const Value* pCell{ GetCellInfluence(col, row) };
+								for (int layer = 0; layer < m_NrOfLayers; ++layer)
+								{
+									const float influence{ T_InfluencePolicy::ToFloat(pCell[layer]) };
+									lowest[layer] = min(lowest[layer], influence);
+									highest[layer] = max(highest[layer], influence);
+									sum[layer] += influence;
+								}
+							}
+						}
+					}
+					else
+					{
+						const InfluenceBlockLevel& children{ m_Pyramid[levelIdx - 1] };
+						const int endRow{ min((blockRow + 1) * m_PyramidBranching, children.rows) };
+						const int endCol{ min((blockCol + 1) * m_PyramidBranching, children.columns) };
+						for (int row = blockRow * m_PyramidBranching; row < endRow; ++row)
+						{
+							for (int col = blockCol * m_PyramidBranching; col < endCol; ++col)
+							{
+								const int child{ (row * children.columns + col) * m_NrOfLayers };
+								for (int layer = 0; layer < m_NrOfLayers; ++layer)
+								{
+									lowest[layer] = min(lowest[layer], children.lowest[child + layer]);
+									highest[layer] = max(highest[layer], children.highest[child + layer]);
+									sum[layer] += children.sum[child + layer];
+								}
+							}
+						}
+					}
+
+					const int block{ (blockRow * level.columns + blockCol) * m_NrOfLayers };
+					std::copy(lowest, lowest + m_NrOfLayers, level.lowest.begin() + block);
+					std::copy(highest, highest + m_NrOfLayers, level.highest.begin() + block);
+					std::copy(sum, sum + m_NrOfLayers, level.sum.begin() + block);
+				}
+			}
+		}
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	bool InfluenceMap<T_GraphType, T_InfluencePolicy>::GetCircleArea(const Elite::Vector2& pos, float radius, CellArea& area) const
+	{
+		area.isCircle = true;
+		area.center = pos;
+		area.radius = radius;
+		return GetNodeRangeInRect(pos, { radius * 2, radius * 2 }, area.minCol, area.minRow, area.maxCol, area.maxRow);
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	bool InfluenceMap<T_GraphType, T_InfluencePolicy>::GetRectArea(const Elite::Vector2& pos, const Elite::Vector2& size, CellArea& area) const
+	{
+		area.isCircle = false;
+		return GetNodeRangeInRect(pos, size, area.minCol, area.minRow, area.maxCol, area.maxRow);
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	typename InfluenceMap<T_GraphType, T_InfluencePolicy>::BlockOverlap InfluenceMap<T_GraphType, T_InfluencePolicy>::GetBlockOverlap(const CellArea& area, int beginCol, int beginRow, int lastCol, int lastRow) const
+	{
+		if (lastCol < area.minCol || beginCol > area.maxCol || lastRow < area.minRow || beginRow > area.maxRow)
+			return BlockOverlap::None;
+
+		const bool isInRange{ beginCol >= area.minCol && lastCol <= area.maxCol && beginRow >= area.minRow && lastRow <= area.maxRow };
+		if (!area.isCircle)
+			return isInRange ? BlockOverlap::Full : BlockOverlap::Partial;
+
+		// compare the closest and farthest point of the rect spanned by the node positions of the block with the radius
+		const Vector2 first{ GetNodeWorldPos(beginRow * GetColumns() + beginCol) };
+		const Vector2 last{ GetNodeWorldPos(lastRow * GetColumns() + lastCol) };
+		const Vector2 closest{ Clamp(area.center.x, first.x, last.x) - area.center.x, Clamp(area.center.y, first.y, last.y) - area.center.y };
+		if (closest.MagnitudeSquared() > area.radius * area.radius)
+			return BlockOverlap::None;
+
+		const Vector2 farthest{ max(abs(first.x - area.center.x), abs(last.x - area.center.x)), max(abs(first.y - area.center.y), abs(last.y - area.center.y)) };
+		return farthest.MagnitudeSquared() <= area.radius * area.radius ? BlockOverlap::Full : BlockOverlap::Partial;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	inline bool InfluenceMap<T_GraphType, T_InfluencePolicy>::GetAreaSpan(const CellArea& area, int row, int& minCol, int& maxCol) const
+	{
+		if (!area.isCircle)
+		{
+			minCol = area.minCol;
+			maxCol = area.maxCol;
+			return true;
+		}
+
+		return GetNodeSpanInRadius(area.center, area.radius, row, minCol, maxCol);
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	template <typename T_Skip, typename T_Block, typename T_Cell>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::VisitArea(const CellArea& area, T_Skip skipBlock, T_Block onBlock, T_Cell onCell) const
+	{
+		if (m_IsBufferDirty || m_Pyramid.empty())
+			return;
+
+		// the top level blocks are the tiles, only the ones the query reaches get brought up to date
+		const int top{ static_cast<int>(m_Pyramid.size()) - 1 };
+		for (int tileRow = area.minRow / m_TileSize; tileRow <= area.maxRow / m_TileSize; ++tileRow)
+		{
+			for (int tileCol = area.minCol / m_TileSize; tileCol <= area.maxCol / m_TileSize; ++tileCol)
+			{
+				const int tileIdx{ tileRow * m_TileColumns + tileCol };
+				if (m_IsPyramidTileDirty[tileIdx])
+				{
+					UpdatePyramidTile(tileIdx);
+					m_IsPyramidTileDirty[tileIdx] = 0;
+				}
+
+				VisitBlock(area, top, tileIdx, skipBlock, onBlock, onCell);
+			}
+		}
+	}
+
+	// skipBlock(level, block) leaves a block out, onBlock(level, block) gets the blocks completely inside the area
+	// and returns false to have their cells visited anyway, onCell(idx) gets the cells of the blocks that weren't handled
+	template <class T_GraphType, class T_InfluencePolicy>
+	template <typename T_Skip, typename T_Block, typename T_Cell>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::VisitBlock(const CellArea& area, int levelIdx, int blockIdx, T_Skip& skipBlock, T_Block& onBlock, T_Cell& onCell) const
+	{
+		const InfluenceBlockLevel& level{ m_Pyramid[levelIdx] };
+		const int beginCol{ (blockIdx % level.columns) * level.blockSize };
+		const int lastCol{ min(beginCol + level.blockSize, GetColumns()) - 1 };
+		const int beginRow{ (blockIdx / level.columns) * level.blockSize };
+		const int lastRow{ min(beginRow + level.blockSize, GetRows()) - 1 };
+
+		const BlockOverlap overlap{ GetBlockOverlap(area, beginCol, beginRow, lastCol, lastRow) };
+		if (overlap == BlockOverlap::None || skipBlock(levelIdx, blockIdx))
+			return;
+
+		if (overlap == BlockOverlap::Full && onBlock(levelIdx, blockIdx))
+			return;
+
+		if (levelIdx == 0)
+		{
+			for (int row = max(beginRow, area.minRow); row <= min(lastRow, area.maxRow); ++row)
+			{
+				int minCol, maxCol;
+				if (!GetAreaSpan(area, row, minCol, maxCol))
+					continue;
+
+				for (int col = max(beginCol, minCol); col <= min(lastCol, maxCol); ++col)
+					onCell(row * GetColumns() + col);
+			}
+			return;
+		}
+
+		const InfluenceBlockLevel& children{ m_Pyramid[levelIdx - 1] };
+		for (int row = beginRow / children.blockSize; row <= lastRow / children.blockSize; ++row)
+		{
+			for (int col = beginCol / children.blockSize; col <= lastCol / children.blockSize; ++col)
+				VisitBlock(area, levelIdx - 1, row * children.columns + col, skipBlock, onBlock, onCell);
+		}
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	float InfluenceMap<T_GraphType, T_InfluencePolicy>::GetExtremeInfluence(const CellArea& area, int layer, bool isMax) const
+	{
+		// searched as a minimum, the maximum is the minimum of the negated influence
+		const float sign{ isMax ? -1.f : 1.f };
+		float lowest{ FLT_MAX };
+
+		VisitArea(area,
+			[&](int level, int block)
+			{
+				const auto& values{ isMax ? m_Pyramid[level].highest : m_Pyramid[level].lowest };
+				return sign * values[block * m_NrOfLayers + layer] >= lowest;
+			},
+			[&](int level, int block)
+			{
+				const auto& values{ isMax ? m_Pyramid[level].highest : m_Pyramid[level].lowest };
+				lowest = sign * values[block * m_NrOfLayers + layer];
+				return true;
+			},
+			[&](int idx) { lowest = min(lowest, sign * GetInfluence(idx, layer)); });
+
+		return lowest == FLT_MAX ? 0.f : sign * lowest;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	float InfluenceMap<T_GraphType, T_InfluencePolicy>::GetMinInfluenceInRadius(const Elite::Vector2& pos, float radius, int layer) const
+	{
+		CellArea area{};
+		return GetCircleArea(pos, radius, area) ? GetExtremeInfluence(area, layer, false) : 0.f;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	float InfluenceMap<T_GraphType, T_InfluencePolicy>::GetMaxInfluenceInRadius(const Elite::Vector2& pos, float radius, int layer) const
+	{
+		CellArea area{};
+		return GetCircleArea(pos, radius, area) ? GetExtremeInfluence(area, layer, true) : 0.f;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	float InfluenceMap<T_GraphType, T_InfluencePolicy>::GetMinInfluenceInRect(const Elite::Vector2& pos, const Elite::Vector2& size, int layer) const
+	{
+		CellArea area{};
+		return GetRectArea(pos, size, area) ? GetExtremeInfluence(area, layer, false) : 0.f;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	float InfluenceMap<T_GraphType, T_InfluencePolicy>::GetMaxInfluenceInRect(const Elite::Vector2& pos, const Elite::Vector2& size, int layer) const
+	{
+		CellArea area{};
+		return GetRectArea(pos, size, area) ? GetExtremeInfluence(area, layer, true) : 0.f;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	float InfluenceMap<T_GraphType, T_InfluencePolicy>::GetMaxInfluenceInRadius(const Elite::Vector2& pos, float radius, const std::vector<float>& layerWeights) const
+	{
+		CellArea area{};
+		if (!GetCircleArea(pos, radius, area))
+			return 0.f;
+
+		float highest{ -FLT_MAX };
+		VisitArea(area,
+			[&](int level, int block)
+			{
+				// upper bound of the weighted influence in the block
+				float bound{ 0 };
+				for (int layer = 0; layer < m_NrOfLayers && layer < static_cast<int>(layerWeights.size()); ++layer)
+				{
+					const auto& values{ layerWeights[layer] > 0 ? m_Pyramid[level].highest : m_Pyramid[level].lowest };
+					bound += layerWeights[layer] * values[block * m_NrOfLayers + layer];
+				}
+				return bound <= highest;
+			},
+			[](int, int) { return false; },
+			[&](int idx) { highest = max(highest, GetInfluence(idx, layerWeights)); });
+
+		return highest == -FLT_MAX ? 0.f : highest;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	float InfluenceMap<T_GraphType, T_InfluencePolicy>::GetInfluenceSumInRadius(const Elite::Vector2& pos, float radius, int layer) const
+	{
+		CellArea area{};
+		return GetCircleArea(pos, radius, area) ? static_cast<float>(GetInfluenceSum(area, layer)) : 0.f;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	double InfluenceMap<T_GraphType, T_InfluencePolicy>::GetInfluenceSum(const CellArea& area, int layer) const
+	{
+		double sum{ 0 };
+		VisitArea(area,
+			[&](int level, int block) { return m_Pyramid[level].lowest[block * m_NrOfLayers + layer] == 0.f && m_Pyramid[level].highest[block * m_NrOfLayers + layer] == 0.f; },
+			[&](int level, int block) { sum += m_Pyramid[level].sum[block * m_NrOfLayers + layer]; return true; },
+			[&](int idx) { sum += GetInfluence(idx, layer); });
+
+		return sum;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	template <typename T_Function>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::ForEachInfluenceInRadius(const Elite::Vector2& pos, float radius, int layer, T_Function function) const
+	{
+		CellArea area{};
+		if (!GetCircleArea(pos, radius, area))
+			return;
+
+		VisitArea(area,
+			[&](int level, int block) { return m_Pyramid[level].lowest[block * m_NrOfLayers + layer] == 0.f && m_Pyramid[level].highest[block * m_NrOfLayers + layer] == 0.f; },
+			[](int, int) { return false; },
+			[&](int idx)
+			{
+				const float influence{ GetInfluence(idx, layer) };
+				if (influence != 0.f)
+					function(idx, influence);
+			});
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	bool InfluenceMap<T_GraphType, T_InfluencePolicy>::FindSafePath(int startIdx, int goalIdx, const PathSettings& settings, std::vector<int>& path) const
+	{
+		path.clear();
+		if (!IsBufferValid(startIdx) || !IsBufferValid(goalIdx))
+			return false;
+
+		m_PathRecords.Begin(GetColumns() * GetRows());
+		m_PathOpenList.Begin(GetColumns() * GetRows());
+
+		PathRecord& startRecord{ m_PathRecords.Visit(startIdx) };
+		startRecord.heuristicCost = GetPathHeuristic(startIdx, goalIdx);
+		m_PathOpenList.Push(startIdx, { startRecord.heuristicCost, startRecord.heuristicCost });
+
+		int closestIdx{ startIdx };
+		int nrOfExpansions{ 0 };
+		while (!m_PathOpenList.IsEmpty())
+		{
+			const int currentIdx{ m_PathOpenList.PopMin() };
+			const PathRecord& currentRecord{ m_PathRecords.Get(currentIdx) };
+			if (currentRecord.heuristicCost < m_PathRecords.Get(closestIdx).heuristicCost)
+				closestIdx = currentIdx;
+			if (currentIdx == goalIdx || (settings.maxExpansions > 0 && ++nrOfExpansions >= settings.maxExpansions))
+				break;
+
+			const float currentCost{ currentRecord.costSoFar };
+			ForEachNeighbor(currentIdx, [&](int neighborIdx, float cost)
+				{
+					// the penalty scales with the connection cost, so a diagonal step through danger isn't cheaper than two straight ones
+					const float influence{ GetInfluence(neighborIdx, settings.layer) };
+					if (influence < settings.blockingInfluence)
+						return;
+
+					const float costSoFar{ currentCost + cost * (1.f + settings.dangerPenalty * max(-influence, 0.f)) };
+					const bool isVisited{ m_PathRecords.IsVisited(neighborIdx) };
+					if (isVisited && m_PathRecords.Get(neighborIdx).costSoFar <= costSoFar)
+						return;
+
+					PathRecord& record{ m_PathRecords.Visit(neighborIdx) };
+					if (!isVisited)
+						record.heuristicCost = GetPathHeuristic(neighborIdx, goalIdx);
+					record.costSoFar = costSoFar;
+					record.fromIdx = currentIdx;
+					m_PathOpenList.Push(neighborIdx, { costSoFar + record.heuristicCost, record.heuristicCost });
+				});
+		}
+
+		for (int idx = closestIdx; idx != invalid_node_index; idx = m_PathRecords.Get(idx).fromIdx)
+			path.push_back(idx);
+		std::reverse(path.begin(), path.end());
+		return closestIdx == goalIdx;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	bool InfluenceMap<T_GraphType, T_InfluencePolicy>::FindSafePath(const Elite::Vector2& start, const Elite::Vector2& goal, const PathSettings& settings, std::vector<Elite::Vector2>& waypoints) const
+	{
+		const bool isGoalReached{ FindSafePath(GetNodeIdxAtWorldPos(start), GetNodeIdxAtWorldPos(goal), settings, m_PathCells) };
+		GetPathWaypoints(start, m_PathCells, settings.layer, waypoints);
+		if (isGoalReached)
+			waypoints.back() = goal;
+		return isGoalReached;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::GetPathWaypoints(const Elite::Vector2& start, const std::vector<int>& cells, int layer, std::vector<Elite::Vector2>& waypoints) const
+	{
+		waypoints.clear();
+		if (cells.empty())
+			return;
+
+		// Walk the cells, a cell is kept as waypoint when the line from the last waypoint to the cell after it crosses a cell
+		// with more danger than the worst one of the cells it would replace
+		Elite::Vector2 anchor{ start };
+		float worstInfluence{ GetInfluence(cells.front(), layer) };
+		for (size_t i = 1; i + 1 < cells.size(); ++i)
+		{
+			worstInfluence = min(worstInfluence, GetInfluence(cells[i], layer));
+			const float threshold{ min(worstInfluence, GetInfluence(cells[i + 1], layer)) };
+			if (IsInLineOfSight(anchor, GetNodeWorldPos(cells[i + 1]), [&](int idx) { return GetInfluence(idx, layer) < threshold; }))
+				continue;
+
+			anchor = GetNodeWorldPos(cells[i]);
+			waypoints.push_back(anchor);
+			worstInfluence = GetInfluence(cells[i], layer);
+		}
+
+		waypoints.push_back(GetNodeWorldPos(cells.back()));
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	float InfluenceMap<T_GraphType, T_InfluencePolicy>::GetPathHeuristic(int fromIdx, int toIdx) const
+	{
+		// octile distance with the grid's own costs, the penalties only add to it so it never overestimates
+		const int columns{ GetColumns() };
+		const float deltaCol{ static_cast<float>(abs(fromIdx % columns - toIdx % columns)) };
+		const float deltaRow{ static_cast<float>(abs(fromIdx / columns - toIdx / columns)) };
+		if (!IsConnectedDiagonally())
+			return (deltaCol + deltaRow) * GetDefaultCostStraight();
+
+		const float diagonalCost{ min(GetDefaultCostDiagonal(), 2.f * GetDefaultCostStraight()) };
+		return (max(deltaCol, deltaRow) - min(deltaCol, deltaRow)) * GetDefaultCostStraight() + min(deltaCol, deltaRow) * diagonalCost;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::WatchChanges(int layer, float threshold)
+	{
+		m_WatchedLayer = layer;
+		m_WatchThreshold = threshold;
+
+		const int nrOfCells{ GetColumns() * GetRows() };
+		m_ReportedInfluence.resize(nrOfCells);
+		for (int idx = 0; idx < nrOfCells; ++idx)
+			m_ReportedInfluence[idx] = GetInfluence(idx, layer);
+		m_IsCellChanged.assign(nrOfCells, 0);
+		for (auto& changedCells : m_ChangedCells)
+			changedCells.clear();
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	int InfluenceMap<T_GraphType, T_InfluencePolicy>::AddChangeList()
+	{
+		assert(m_ChangedCells.size() < m_MaxChangeLists && "<InfluenceMap::AddChangeList>: a cell keeps a bit per list");
+		m_ChangedCells.emplace_back();
+		return static_cast<int>(m_ChangedCells.size()) - 1;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	void InfluenceMap<T_GraphType, T_InfluencePolicy>::TakeChangedCells(std::vector<int>& cells, int list)
+	{
+		cells.clear();
+		cells.swap(m_ChangedCells[list]);
+		for (int idx : cells)
+			m_IsCellChanged[idx] &= ~(1 << list);
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	inline void InfluenceMap<T_GraphType, T_InfluencePolicy>::CheckForChange(int idx)
+	{
+		if (idx >= static_cast<int>(m_ReportedInfluence.size()))
+			return;
+
+		// compared with the last value handed out, so a slow drift gets reported too once it adds up
+		const float influence{ GetInfluence(idx, m_WatchedLayer) };
+		if (abs(influence - m_ReportedInfluence[idx]) <= m_WatchThreshold)
+			return;
+
+		m_ReportedInfluence[idx] = influence;
+		for (int list = 0; list < static_cast<int>(m_ChangedCells.size()); ++list)
+		{
+			if (!(m_IsCellChanged[idx] & (1 << list)))
+			{
+				m_IsCellChanged[idx] |= 1 << list;
+				m_ChangedCells[list].push_back(idx);
+			}
+		}
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	inline void InfluenceMap<T_GraphType, T_InfluencePolicy>::SetItem(int idx, const ItemInfo& item)
+	{
+		if (!IsBufferValid(idx))
+			return;
+
+		// The node keeps the exact item position, the flat array is used for lookups
+		GetNode(idx)->SetItem(item);
+		TouchChunk(GetChunkIdx(idx % GetColumns(), idx / GetColumns())).itemTypes[GetChunkOffset(idx % GetColumns(), idx / GetColumns())] = item.Type;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	inline void InfluenceMap<T_GraphType, T_InfluencePolicy>::RemoveItem(int idx)
+	{
+		if (!IsBufferValid(idx))
+			return;
+
+		GetNode(idx)->RemoveItem();
+		Chunk* pChunk{ m_Chunks[GetChunkIdx(idx % GetColumns(), idx / GetColumns())].get() };
+		if (pChunk)
+			pChunk->itemTypes[GetChunkOffset(idx % GetColumns(), idx / GetColumns())] = eItemType::INVALID;
+	}
+
+	template <class T_GraphType, class T_InfluencePolicy>
+	inline eItemType InfluenceMap<T_GraphType, T_InfluencePolicy>::GetItemType(int idx) const
+	{
+		const Chunk* pChunk{ m_Chunks[GetChunkIdx(idx % GetColumns(), idx / GetColumns())].get() };
+		return pChunk ? pChunk->itemTypes[GetChunkOffset(idx % GetColumns(), idx / GetColumns())] : eItemType::INVALID;
+	}
+
+	template<class T_GraphType, class T_InfluencePolicy>
+	inline void InfluenceMap<T_GraphType, T_InfluencePolicy>::SetNodeColorsBasedOnInfluence()
 	{
 		const float half = .5f;
-		
+
 		for (auto& pNode : m_Nodes)
 		{
+			const int idx{ pNode->GetIndex() };
+			if (!IsBufferValid(idx))
+				continue;
+
+			// Copy the flat data to the node so the renderer can draw it
+			float influence{ 0 };
+			if (m_RenderLayerWeights.empty())
+			{
+				for (int layer = 0; layer < m_NrOfLayers; ++layer)
+					influence += GetInfluence(idx, layer);
+			}
+			else
+			{
+				influence = GetInfluence(idx, m_RenderLayerWeights);
+			}
+			pNode->SetInfluence(influence);
+			pNode->SetScanned(IsScanned(idx));
+
 			Color nodeColor{};
-			float influence = pNode->GetInfluence();
 			float relativeInfluence = abs(influence) / m_MaxAbsInfluence;
 
 			if (influence < 0)
@@ -206,9 +1812,11 @@ namespace Elite
 	}
 
 
-	template<class T_GraphType>
-	inline void InfluenceMap<T_GraphType>::OnGraphModified(bool nrOfNodesChanged, bool nrOfConnectionsChanged)
+	template<class T_GraphType, class T_InfluencePolicy>
+	inline void InfluenceMap<T_GraphType, T_InfluencePolicy>::OnGraphModified(bool nrOfNodesChanged, bool nrOfConnectionsChanged)
 	{
-		InitializeBuffer();
+		// Resizing on every single modification made building the grid quadratic, the buffers are rebuilt lazily instead
+		m_IsBufferDirty = true;
+		m_IsRegularGrid = false;
 	}
-}
\ No newline at end of file
+}
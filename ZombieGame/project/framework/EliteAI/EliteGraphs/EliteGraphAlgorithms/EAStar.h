@@ -1,5 +1,7 @@
 #pragma once
-#include "framework/EliteAI/EliteNavigation/ENavigation.h"
+#include "../EIGraph.h"
+#include "../EliteGraphUtilities/EGraphSearch.h"
+#include "EHeuristicFunctions.h"
 
 namespace Elite
 {
@@ -8,32 +10,17 @@ namespace Elite
 	{
 	public:
 		AStar(IGraph<T_NodeType, T_ConnectionType>* pGraph, Heuristic hFunction);
-		//AStar(InfluenceMap<GridGraph<T_NodeType, T_ConnectionType>>* pGraph, Heuristic hFunction);
 
-
-		// stores the optimal connection to a node and its total costs related to the start and end node of the path
+		// stores the cheapest way found to a node so far, indexed by node index
 		struct NodeRecord
 		{
-			T_NodeType* pNode = nullptr;
-			T_ConnectionType* pConnection = nullptr;
-			float costSoFar = 0.f; // accumulated g-costs of all the connections leading up to this one
-			float estimatedTotalCost = 0.f; // f-cost (= costSoFar + h-cost)
-
-			bool operator==(const NodeRecord& other) const
-			{
-				return pNode == other.pNode
-					&& pConnection == other.pConnection
-					&& costSoFar == other.costSoFar
-					&& estimatedTotalCost == other.estimatedTotalCost;
-			};
-
-			bool operator<(const NodeRecord& other) const
-			{
-				return estimatedTotalCost < other.estimatedTotalCost;
-			};
+			float costSoFar = 0.f; // accumulated g-costs of all the connections leading up to this node
+			float heuristicCost = 0.f; // h-cost to the goal, worked out once per search
+			int fromIdx = invalid_node_index; // the node the cheapest connection comes from
 		};
 
-		std::vector<T_NodeType*> FindPath(T_NodeType* pStartNode, T_NodeType* pDestinationNode);
+		// The nodes from start to goal, empty if the goal can't be reached
+		std::vector<T_NodeType*> FindPath(T_NodeType* pStartNode, T_NodeType* pGoalNode);
 
 	private:
 		float GetHeuristicCost(T_NodeType* pStartNode, T_NodeType* pEndNode) const;
@@ -41,14 +28,11 @@ namespace Elite
 		IGraph<T_NodeType, T_ConnectionType>* m_pGraph;
 		Heuristic m_HeuristicFunction;
 
-
-		//helper functions
-		NodeRecord GetLowestFScoreConnection(std::vector<NodeRecord> fromList)
-		{
-			return *std::min_element(fromList.begin(), fromList.end());
-		}
+		// kept between searches, so a search doesn't allocate once they're big enough for the graph
+		SearchRecords<NodeRecord> m_Records;
+		NodeHeap<EstimatedCostKey> m_OpenList;
 	};
-	
+
 
 	template <class T_NodeType, class T_ConnectionType>
 	AStar<T_NodeType, T_ConnectionType>::AStar(IGraph<T_NodeType, T_ConnectionType>* pGraph, Heuristic hFunction)
@@ -60,111 +44,58 @@ namespace Elite
 	template <class T_NodeType, class T_ConnectionType>
 	std::vector<T_NodeType*> AStar<T_NodeType, T_ConnectionType>::FindPath(T_NodeType* pStartNode, T_NodeType* pGoalNode)
 	{
-		//2.D wrong check english slides! -> "Connection to the connections endNode => This connection already points to a previously visited node
 		std::vector<T_NodeType*> path;
-		std::vector<NodeRecord> openList{}; //connections to be checked
-		std::vector<NodeRecord> closedList{}; //connections already checked
-		NodeRecord currentRecord{};
+		if (!pStartNode || !pGoalNode || pStartNode->GetIndex() == invalid_node_index || pGoalNode->GetIndex() == invalid_node_index)
+			return path;
 
-		const NodeRecord startRecord{ pStartNode, nullptr, GetHeuristicCost(pStartNode, pGoalNode) };
-		openList.push_back(startRecord);
+		const int startIdx{ pStartNode->GetIndex() };
+		const int goalIdx{ pGoalNode->GetIndex() };
+		m_Records.Begin(m_pGraph->GetNrOfNodes());
+		m_OpenList.Begin(m_pGraph->GetNrOfNodes());
 
-		//--------------STEP 1 COMPLETE---------------\\
+		NodeRecord& startRecord{ m_Records.Visit(startIdx) };
+		startRecord.heuristicCost = GetHeuristicCost(pStartNode, pGoalNode);
+		m_OpenList.Push(startIdx, { startRecord.heuristicCost, startRecord.heuristicCost });
 
-		//2.
-		while(!openList.empty())
+		bool isGoalReached{ false };
+		while (!m_OpenList.IsEmpty())
 		{
-			//get connection with lowest F score
-			currentRecord = GetLowestFScoreConnection(openList);
-
-			//check if that connection leads to the end node. if so, end loop
-			if (currentRecord.pConnection && currentRecord.pConnection->GetTo() == pGoalNode->GetIndex()) break;
-
-			//else get all connections current node, loop over them
-			const auto currentRecordConnections{ m_pGraph->GetNodeConnections(currentRecord.pNode) };
-
-			//For each of the connections
-			for(auto& connectionFromCurrentRecord : currentRecordConnections)
+			// the node with the lowest f-cost is done, no cheaper way to it can turn up any more
+			const int currentIdx{ m_OpenList.PopMin() };
+			if (currentIdx == goalIdx)
 			{
-				//---------------STEP 2.1 COMPLETE-----------------\\
-				// 
-				//calculate g-cost so far
-				T_NodeType* nextNode{ m_pGraph->GetNode(connectionFromCurrentRecord->GetTo()) };
-				float gCost = currentRecord.costSoFar + 1 + GetHeuristicCost(currentRecord.pNode, pGoalNode) + connectionFromCurrentRecord->GetCost();
-
-				//Check if any of those connections lead to a node already on the closed list
-				bool isExistingConnectionCheaper{};
-				for (auto& existingRecord : closedList)
-				{
-					if (connectionFromCurrentRecord->GetTo() == existingRecord.pNode->GetIndex()) // if connection leads to already checked connection
-					{
-						if (existingRecord.costSoFar < gCost) //Check if the already existing connection is cheaper 
-						{
-							//don't execute 2.F..
-							isExistingConnectionCheaper = true;
-							break;
-						}
-						else
-						{
-							closedList.erase(std::remove(closedList.begin(), closedList.end(), existingRecord));
-						}
-						
-					} 
-				}
-
-				//check if any of those connections lead to a node already on the open list
-				for(auto& existingRecord : openList)
-				{
-					//if a connection to the connections endNode already exist in the open list
-					if(connectionFromCurrentRecord->GetTo() == existingRecord.pNode->GetIndex())
-					{
-						if (existingRecord.costSoFar < gCost) //Check if the already existing connection is cheaper 
-						{
-							//don't execute 2.F..
-							isExistingConnectionCheaper = true;
-							break; 
-						}
-						else
-						{
-							openList.erase(std::remove(openList.begin(), openList.end(), existingRecord));
-						}
-					}
-				}
-
-				if (isExistingConnectionCheaper) continue;
-
-				//2.F
-				//create new nodeRecord, add it to openList
-				NodeRecord newNodeRecord{  };
-				newNodeRecord.pNode = nextNode;
-				newNodeRecord.costSoFar = gCost;
-				newNodeRecord.estimatedTotalCost = gCost + GetHeuristicCost(nextNode, pGoalNode);
-				newNodeRecord.pConnection = connectionFromCurrentRecord;
-				openList.emplace_back(newNodeRecord);
+				isGoalReached = true;
+				break;
 			}
 
-			//move current record to closed list
-			closedList.push_back(currentRecord);
-			openList.erase(std::remove(openList.begin(), openList.end(), currentRecord));
+			const float currentCost{ m_Records.Get(currentIdx).costSoFar };
+			for (const auto neighbor : m_pGraph->GetNeighbors(currentIdx))
+			{
+				// g-cost is only what the connections cost, the heuristic goes into the f-cost
+				const float costSoFar{ currentCost + neighbor.cost };
 
-		}
+				const bool isVisited{ m_Records.IsVisited(neighbor.to) };
+				if (isVisited && m_Records.Get(neighbor.to).costSoFar <= costSoFar)
+					continue;
 
-		//3. Reconstruct path from last connection to start node
-		while (currentRecord.pNode != pStartNode)
-		{
-			path.emplace_back(currentRecord.pNode);
-			//look in the closedList for a record where pNode == currentRecord connection startNode
-			for(auto& record : closedList)
-			{
-				if (record.pNode->GetIndex() == currentRecord.pConnection->GetFrom()) // found record
-				{
-					currentRecord = record; //set new currentRecord to found record
-					break;
-				} 
+				NodeRecord& record{ m_Records.Visit(neighbor.to) };
+				if (!isVisited)
+					record.heuristicCost = GetHeuristicCost(m_pGraph->GetNode(neighbor.to), pGoalNode);
+				record.costSoFar = costSoFar;
+				record.fromIdx = currentIdx;
+
+				// a node that was done already goes back on the open list with its cheaper cost (only with a heuristic that overestimates)
+				m_OpenList.Push(neighbor.to, { costSoFar + record.heuristicCost, record.heuristicCost });
 			}
 		}
 
-		path.emplace_back(pStartNode);
+		if (!isGoalReached)
+			return path;
+
+		// backtrack from the goal through the records
+		for (int idx = goalIdx; idx != invalid_node_index; idx = m_Records.Get(idx).fromIdx)
+			path.push_back(m_pGraph->GetNode(idx));
+
 		std::reverse(path.begin(), path.end());
 		return path;
 	}
@@ -174,6 +105,6 @@ namespace Elite
 	float Elite::AStar<T_NodeType, T_ConnectionType>::GetHeuristicCost(T_NodeType* pStartNode, T_NodeType* pEndNode) const
 	{
 		Vector2 toDestination = m_pGraph->GetNodePos(pEndNode) - m_pGraph->GetNodePos(pStartNode);
-		return m_HeuristicFunction(abs(toDestination.x), abs(toDestination.y));
+		return m_HeuristicFunction(std::abs(toDestination.x), std::abs(toDestination.y));
 	}
-}
\ No newline at end of file
+}
@@ -35,9 +35,9 @@ namespace Elite
 
 			if (pCurrentNode == pDestinationNode) break;
 
-			for(auto& connection : m_pGraph->GetNodeConnections(pCurrentNode))
+			for(const auto neighbor : m_pGraph->GetNeighbors(pCurrentNode))
 			{
-				T_NodeType* pNextNode{ m_pGraph->GetNode(connection->GetTo()) };
+				T_NodeType* pNextNode{ m_pGraph->GetNode(neighbor.to) };
 				
 				if (closedList.find(pNextNode) != closedList.end()) continue;
 
@@ -0,0 +1,319 @@
+#pragma once
+#include "../EGridGraph.h"
+#include "../EliteGraphUtilities/EGraphSearch.h"
+#include "EHeuristicFunctions.h"
+#include <functional>
+#include <cfloat>
+
+namespace Elite
+{
+	// D* Lite (Koenig & Likhachev): A* backwards from the goal that keeps its search tree between queries. When the cost of
+	// some cells changes, only the part of the tree that depends on them gets repaired, and the start can move along the path
+	// in between. Replanning to the same goal while walking a map whose costs keep changing is a fraction of a search from scratch.
+	// Stepping into a cell costs what the cost function makes of the connection cost, so the costs can come from an InfluenceMap.
+	// It's told about the cells whose cost changed with OnCellChanged (see InfluenceMap::TakeChangedCells). Any other edit of the
+	// grid (see IGraph::GetRevision) starts a new search.
+	// The connections have to go both ways with the same cost, the cost function puts the direction in. It shouldn't go below
+	// the connection cost, or the heuristic can overestimate.
+	template <class T_NodeType, class T_ConnectionType>
+	class DStarLite
+	{
+	public:
+		// The cost of stepping into toIdx over a connection with that cost
+		using CostFunction = std::function<float(int toIdx, float connectionCost)>;
+
+		DStarLite(GridGraph<T_NodeType, T_ConnectionType>* pGrid, Heuristic hFunction, CostFunction costFunction = nullptr);
+
+		// The nodes from start to goal, empty if the goal can't be reached. A new goal starts a new search, the goal of the
+		// last query repairs that search
+		std::vector<T_NodeType*> FindPath(T_NodeType* pStartNode, T_NodeType* pGoalNode);
+		bool FindPath(int startIdx, int goalIdx, std::vector<int>& path);
+
+		// To be called when the cost of stepping into the cell changed, the search gets repaired on the next query
+		void OnCellChanged(int idx) { m_ChangedCells.push_back(idx); }
+		template <typename T_Indices>
+		void OnCellsChanged(const T_Indices& indices) { m_ChangedCells.insert(m_ChangedCells.end(), std::begin(indices), std::end(indices)); }
+
+		// nodes the last query took off the open list, to see what a repair cost next to a search from scratch
+		int GetNrOfExpansions() const { return m_NrOfExpansions; }
+
+	private:
+		// g is the cost to the goal as the search worked it out, rhs the one its successors (the neighbors) point to.
+		// A node with both the same is consistent, the others wait on the open list.
+		struct NodeRecord
+		{
+			float costToGoal = FLT_MAX; // g
+			float lookaheadCost = FLT_MAX; // rhs
+			int nextIdx = invalid_node_index; // the neighbor the lookahead cost goes through
+		};
+
+		// lowest first on the estimate through the node, on a tie on the lowest cost to the goal
+		struct Key
+		{
+			float estimatedCost;
+			float costToGoal;
+
+			bool operator<(const Key& other) const
+			{
+				return estimatedCost < other.estimatedCost
+					|| (estimatedCost == other.estimatedCost && costToGoal < other.costToGoal);
+			}
+		};
+
+		GridGraph<T_NodeType, T_ConnectionType>* m_pGrid;
+		Heuristic m_HeuristicFunction;
+		CostFunction m_CostFunction;
+
+		SearchRecords<NodeRecord> m_Records;
+		NodeHeap<Key> m_OpenList;
+		std::vector<int> m_ChangedCells;
+		std::vector<int> m_PathCells;
+
+		bool m_IsSearchValid{ false };
+		int m_StartIdx{ invalid_node_index };
+		int m_GoalIdx{ invalid_node_index };
+		float m_KeyModifier{ 0.f }; // km, what the heuristic of the keys on the open list is short since the start moved
+		unsigned int m_KnownRevision{ 0 };
+		int m_NrOfExpansions{ 0 };
+
+		void Reset(int startIdx, int goalIdx);
+		void ComputeShortestPath();
+		void UpdateNode(int idx);
+		Key CalculateKey(int idx) const;
+
+		const NodeRecord& GetRecord(int idx) const;
+		float GetCost(int toIdx, float connectionCost) const { return m_CostFunction ? m_CostFunction(toIdx, connectionCost) : connectionCost; }
+		// the cheapest way to the goal over one of the neighbors
+		void UpdateLookahead(int idx);
+		float GetHeuristicCost(int fromIdx, int toIdx) const;
+	};
+
+
+	template <class T_NodeType, class T_ConnectionType>
+	DStarLite<T_NodeType, T_ConnectionType>::DStarLite(GridGraph<T_NodeType, T_ConnectionType>* pGrid, Heuristic hFunction, CostFunction costFunction)
+		: m_pGrid(pGrid)
+		, m_HeuristicFunction(hFunction)
+		, m_CostFunction(costFunction)
+	{
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	std::vector<T_NodeType*> DStarLite<T_NodeType, T_ConnectionType>::FindPath(T_NodeType* pStartNode, T_NodeType* pGoalNode)
+	{
+		std::vector<T_NodeType*> path;
+		if (!pStartNode || !pGoalNode || !FindPath(pStartNode->GetIndex(), pGoalNode->GetIndex(), m_PathCells))
+			return path;
+
+		path.reserve(m_PathCells.size());
+		for (int idx : m_PathCells)
+			path.push_back(m_pGrid->GetNode(idx));
+		return path;
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	bool DStarLite<T_NodeType, T_ConnectionType>::FindPath(int startIdx, int goalIdx, std::vector<int>& path)
+	{
+		path.clear();
+		m_NrOfExpansions = 0;
+		if (!m_pGrid->IsNodeValid(startIdx) || !m_pGrid->IsNodeValid(goalIdx))
+			return false;
+
+		if (!m_IsSearchValid || goalIdx != m_GoalIdx || m_KnownRevision != m_pGrid->GetRevision())
+		{
+			Reset(startIdx, goalIdx);
+		}
+		else
+		{
+			// the keys on the open list were worked out from the old start, the heuristic to the new one can be that much lower
+			if (startIdx != m_StartIdx)
+			{
+				m_KeyModifier += GetHeuristicCost(m_StartIdx, startIdx);
+				m_StartIdx = startIdx;
+			}
+
+			// Only the steps into a changed cell cost something else. A neighbor that went through it looks for the cheapest way
+			// again, the others only take it when it got cheaper. Nodes the search never reached can't have a way yet.
+			for (int changedIdx : m_ChangedCells)
+			{
+				const float costToGoal{ GetRecord(changedIdx).costToGoal };
+				m_pGrid->ForEachNeighbor(changedIdx, [&](int idx, float connectionCost)
+					{
+						if (idx == m_GoalIdx || !m_Records.IsVisited(idx))
+							return;
+
+						NodeRecord& record{ m_Records.Get(idx) };
+						if (record.nextIdx == changedIdx)
+						{
+							UpdateLookahead(idx);
+							UpdateNode(idx);
+						}
+						else if (costToGoal != FLT_MAX && GetCost(changedIdx, connectionCost) + costToGoal < record.lookaheadCost)
+						{
+							record.lookaheadCost = GetCost(changedIdx, connectionCost) + costToGoal;
+							record.nextIdx = changedIdx;
+							UpdateNode(idx);
+						}
+					});
+			}
+		}
+		m_ChangedCells.clear();
+
+		ComputeShortestPath();
+		if (GetRecord(startIdx).lookaheadCost == FLT_MAX)
+			return false;
+
+		// the nodes along the cheapest way are all consistent, their lookahead leads to the goal
+		path.push_back(startIdx);
+		for (int currentIdx = startIdx; currentIdx != goalIdx; )
+		{
+			currentIdx = GetRecord(currentIdx).nextIdx;
+
+			// only a search that went wrong leaves a dead end or a loop
+			if (currentIdx == invalid_node_index || static_cast<int>(path.size()) > m_pGrid->GetNrOfNodes())
+			{
+				path.clear();
+				return false;
+			}
+
+			path.push_back(currentIdx);
+		}
+
+		return true;
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	void DStarLite<T_NodeType, T_ConnectionType>::Reset(int startIdx, int goalIdx)
+	{
+		m_IsSearchValid = true;
+		m_StartIdx = startIdx;
+		m_GoalIdx = goalIdx;
+		m_KeyModifier = 0.f;
+		m_KnownRevision = m_pGrid->GetRevision();
+
+		m_Records.Begin(m_pGrid->GetNrOfNodes());
+		m_OpenList.Begin(m_pGrid->GetNrOfNodes());
+
+		m_Records.Visit(goalIdx).lookaheadCost = 0.f;
+		m_OpenList.Push(goalIdx, CalculateKey(goalIdx));
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	void DStarLite<T_NodeType, T_ConnectionType>::ComputeShortestPath()
+	{
+		while (!m_OpenList.IsEmpty())
+		{
+			// done once nothing on the open list can still lower the cost of the start, and the start is consistent
+			const NodeRecord& start{ GetRecord(m_StartIdx) };
+			if (!(m_OpenList.GetMinKey() < CalculateKey(m_StartIdx)) && start.lookaheadCost <= start.costToGoal)
+				break;
+
+			const int currentIdx{ m_OpenList.GetMin() };
+			const Key oldKey{ m_OpenList.GetMinKey() };
+			const Key newKey{ CalculateKey(currentIdx) };
+			++m_NrOfExpansions;
+
+			// a key from before the start moved, it only needs to go back in with its real key
+			if (oldKey < newKey)
+			{
+				m_OpenList.Push(currentIdx, newKey);
+				continue;
+			}
+
+			NodeRecord& record{ m_Records.Get(currentIdx) };
+			if (record.costToGoal > record.lookaheadCost)
+			{
+				// a cheaper way was found, it can only lower the lookahead of the neighbors
+				record.costToGoal = record.lookaheadCost;
+				m_OpenList.Remove(currentIdx);
+				const float costToGoal{ record.costToGoal };
+				m_pGrid->ForEachNeighbor(currentIdx, [&](int idx, float connectionCost)
+					{
+						if (idx == m_GoalIdx)
+							return;
+
+						const float lookaheadCost{ GetCost(currentIdx, connectionCost) + costToGoal };
+						NodeRecord& neighbor{ m_Records.Visit(idx) };
+						if (lookaheadCost < neighbor.lookaheadCost)
+						{
+							neighbor.lookaheadCost = lookaheadCost;
+							neighbor.nextIdx = currentIdx;
+							UpdateNode(idx);
+						}
+					});
+			}
+			else
+			{
+				// the way got more expensive, the neighbors that went through this node look for another one
+				record.costToGoal = FLT_MAX;
+				UpdateNode(currentIdx);
+				m_pGrid->ForEachNeighbor(currentIdx, [&](int idx, float)
+					{
+						if (idx == m_GoalIdx || !m_Records.IsVisited(idx) || m_Records.Get(idx).nextIdx != currentIdx)
+							return;
+
+						UpdateLookahead(idx);
+						UpdateNode(idx);
+					});
+			}
+		}
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	void DStarLite<T_NodeType, T_ConnectionType>::UpdateNode(int idx)
+	{
+		const NodeRecord& record{ GetRecord(idx) };
+		if (record.costToGoal != record.lookaheadCost)
+			m_OpenList.Push(idx, CalculateKey(idx));
+		else
+			m_OpenList.Remove(idx);
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	typename DStarLite<T_NodeType, T_ConnectionType>::Key DStarLite<T_NodeType, T_ConnectionType>::CalculateKey(int idx) const
+	{
+		const NodeRecord& record{ GetRecord(idx) };
+		const float costToGoal{ min(record.costToGoal, record.lookaheadCost) };
+		if (costToGoal == FLT_MAX)
+			return { FLT_MAX, FLT_MAX };
+
+		return { costToGoal + GetHeuristicCost(m_StartIdx, idx) + m_KeyModifier, costToGoal };
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	const typename DStarLite<T_NodeType, T_ConnectionType>::NodeRecord& DStarLite<T_NodeType, T_ConnectionType>::GetRecord(int idx) const
+	{
+		// a node the search hasn't reached has no way to the goal yet
+		static const NodeRecord unvisited{};
+		return m_Records.IsVisited(idx) ? m_Records.Get(idx) : unvisited;
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	void DStarLite<T_NodeType, T_ConnectionType>::UpdateLookahead(int idx)
+	{
+		NodeRecord& record{ m_Records.Get(idx) };
+		record.lookaheadCost = FLT_MAX;
+		record.nextIdx = invalid_node_index;
+		m_pGrid->ForEachNeighbor(idx, [&](int neighborIdx, float connectionCost)
+			{
+				const float costToGoal{ GetRecord(neighborIdx).costToGoal };
+				if (costToGoal == FLT_MAX)
+					return;
+
+				const float lookaheadCost{ GetCost(neighborIdx, connectionCost) + costToGoal };
+				if (lookaheadCost < record.lookaheadCost)
+				{
+					record.lookaheadCost = lookaheadCost;
+					record.nextIdx = neighborIdx;
+				}
+			});
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	float DStarLite<T_NodeType, T_ConnectionType>::GetHeuristicCost(int fromIdx, int toIdx) const
+	{
+		const int columns{ m_pGrid->GetColumns() };
+		const float deltaCol{ static_cast<float>(abs(fromIdx % columns - toIdx % columns)) };
+		const float deltaRow{ static_cast<float>(abs(fromIdx / columns - toIdx / columns)) };
+		return m_HeuristicFunction(deltaCol, deltaRow);
+	}
+}
@@ -45,11 +45,10 @@ namespace Elite
 		
 
 		// Count nodes with odd degree 
-		auto nodes{ m_pGraph->GetAllNodes() };
 		int oddCount{ 0 };
-		for (auto n : nodes) {
+		for (auto n : m_pGraph->GetActiveNodes()) {
 
-			auto connections{ m_pGraph->GetNodeConnections(n) };
+			const auto& connections{ m_pGraph->GetNodeConnections(n) };
 
 			if (connections.size() & 1)
 				++oddCount;
@@ -91,7 +90,7 @@ namespace Elite
 		int oddCount{ 0 };
 
 		for (auto n : allNodes) {
-			auto connections{ m_pGraph->GetNodeConnections(n) };
+			const auto& connections{ m_pGraph->GetNodeConnections(n) };
 
 			if (connections.size() % 2) {
 				++oddCount;
@@ -153,22 +152,20 @@ namespace Elite
 	template<class T_NodeType, class T_ConnectionType>
 	inline bool EulerianPath<T_NodeType, T_ConnectionType>::IsConnected() const
 	{
-		auto nodes = m_pGraph->GetAllNodes();
+		const auto nodes = m_pGraph->GetActiveNodes();
 		vector<bool> visited(m_pGraph->GetNrOfNodes(), false);
 
 		// find a valid starting node that has connections
 		int connectedIdx = invalid_node_index;
 
-		if (nodes.size() > 1 && m_pGraph->GetAllConnections().size() == 0)
+		if (m_pGraph->GetNrOfActiveNodes() > 1 && m_pGraph->GetAllConnections().size() == 0)
 		{
 			return false;
 		}
 		
 
-		for (auto& n : nodes) {
-			auto connections{ m_pGraph->GetNodeConnections(n) };
-
-			if (connections.size() != 0) {
+		for (auto n : nodes) {
+			if (!m_pGraph->GetNodeConnections(n).empty()) {
 				connectedIdx = n->GetIndex();
 				break;
 			}
@@ -184,7 +181,7 @@ namespace Elite
 
 
 		// if a node was never visited, this graph is not connected
-		for (auto& n : nodes) {
+		for (auto n : nodes) {
 			if (visited[n->GetIndex()] == false)
 				return false;
 		}
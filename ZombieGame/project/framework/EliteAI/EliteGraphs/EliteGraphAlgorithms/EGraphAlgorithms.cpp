@@ -0,0 +1,6 @@
+#include "../../../../stdafx.h"
+#include "EHPAStar.h"
+
+// Nothing in the agent calls HPAStar yet, compiled for the grid it uses so it can't break unnoticed
+// (JumpPointSearch gets compiled through FollowPath)
+template class Elite::HPAStar<Elite::WorldNode, Elite::GraphConnection>;
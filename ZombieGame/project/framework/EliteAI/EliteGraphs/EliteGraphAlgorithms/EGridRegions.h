@@ -0,0 +1,274 @@
+#pragma once
+#include "../EGridGraph.h"
+#include <vector>
+#include <cstdint>
+
+namespace Elite
+{
+	// Labels the connected regions of passable cells of a grid with a union-find forest, so "can I get there?" is a lookup.
+	// The regions follow the grid's own neighbors (4 or 8, see IsConnectedDiagonally).
+	// Opening a cell only merges it with its neighbors. Blocking one can only split its region when its passable neighbors
+	// don't stay connected through the ring of cells around it, only then the labels are rebuilt, on the next query.
+	// A grid of another size starts over with every cell passable.
+	template <class T_NodeType, class T_ConnectionType>
+	class GridRegions final
+	{
+	public:
+		// every cell starts out passable
+		GridRegions(const GridGraph<T_NodeType, T_ConnectionType>* pGrid);
+
+		// Evaluates isPassable(idx) for every cell and labels the grid from scratch
+		template <typename T_Predicate>
+		void Rebuild(T_Predicate isPassable);
+		void SetPassable(int idx, bool isPassable);
+		bool IsPassable(int idx) const { FitToGrid(); return IsCellPassable(idx); }
+
+		// The root of the region the cell belongs to, invalid_node_index for blocked cells. Only stable until the next change
+		int GetRegion(int idx) const;
+		bool IsSameRegion(int idxA, int idxB) const;
+		int GetNrOfRelabels() const { return m_NrOfRelabels; }
+
+	private:
+		const GridGraph<T_NodeType, T_ConnectionType>* m_pGrid;
+		mutable std::vector<uint8_t> m_IsPassable; // refitted when the grid changes size
+		mutable std::vector<int> m_Parents; // blocked cells stay in the forest, the passable bit decides
+		mutable std::vector<int> m_Sizes;
+		mutable bool m_NeedsRelabel{ false };
+		mutable int m_NrOfRelabels{ 0 };
+
+		bool IsCellPassable(int idx) const { return m_IsPassable[idx] != 0; }
+		void FitToGrid() const;
+		int Find(int idx) const;
+		void Union(int idxA, int idxB) const;
+		void Relabel() const;
+		bool CanSplitRegion(int col, int row) const;
+	};
+
+	template <class T_NodeType, class T_ConnectionType>
+	GridRegions<T_NodeType, T_ConnectionType>::GridRegions(const GridGraph<T_NodeType, T_ConnectionType>* pGrid)
+		: m_pGrid(pGrid)
+	{
+		FitToGrid();
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	template <typename T_Predicate>
+	void GridRegions<T_NodeType, T_ConnectionType>::Rebuild(T_Predicate isPassable)
+	{
+		FitToGrid();
+		for (int idx = 0; idx < static_cast<int>(m_IsPassable.size()); ++idx)
+			m_IsPassable[idx] = isPassable(idx) ? 1 : 0;
+
+		Relabel();
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	void GridRegions<T_NodeType, T_ConnectionType>::SetPassable(int idx, bool isPassable)
+	{
+		FitToGrid();
+		if (IsCellPassable(idx) == isPassable)
+			return;
+
+		m_IsPassable[idx] = isPassable ? 1 : 0;
+		if (m_NeedsRelabel)
+			return;
+
+		const int columns{ m_pGrid->GetColumns() };
+		if (!isPassable)
+		{
+			m_NeedsRelabel = CanSplitRegion(idx % columns, idx / columns);
+			return;
+		}
+
+		// The cell still sits in the set it had before it got blocked. That set is only right for it when it's the cell alone
+		// or a neighbor still belongs to it, otherwise joining it with the neighbors would merge regions that don't touch.
+		const int root{ Find(idx) };
+		bool isInItsRegion{ m_Sizes[root] == 1 };
+		m_pGrid->ForEachNeighbor(idx, [this, root, &isInItsRegion](int neighborIdx, float)
+			{
+				if (!isInItsRegion && IsCellPassable(neighborIdx) && Find(neighborIdx) == root)
+					isInItsRegion = true;
+			});
+		if (!isInItsRegion)
+		{
+			m_NeedsRelabel = true;
+			return;
+		}
+
+		m_pGrid->ForEachNeighbor(idx, [this, idx](int neighborIdx, float)
+			{
+				if (IsCellPassable(neighborIdx))
+					Union(idx, neighborIdx);
+			});
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	int GridRegions<T_NodeType, T_ConnectionType>::GetRegion(int idx) const
+	{
+		FitToGrid();
+		if (idx < 0 || idx >= static_cast<int>(m_IsPassable.size()) || !IsCellPassable(idx))
+			return invalid_node_index;
+
+		if (m_NeedsRelabel)
+			Relabel();
+
+		return Find(idx);
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	bool GridRegions<T_NodeType, T_ConnectionType>::IsSameRegion(int idxA, int idxB) const
+	{
+		const int regionA{ GetRegion(idxA) };
+		return regionA != invalid_node_index && regionA == GetRegion(idxB);
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	void GridRegions<T_NodeType, T_ConnectionType>::FitToGrid() const
+	{
+		const size_t nrOfCells{ static_cast<size_t>(m_pGrid->GetColumns()) * m_pGrid->GetRows() };
+		if (m_IsPassable.size() == nrOfCells)
+			return;
+
+		m_IsPassable.assign(nrOfCells, 1);
+		m_Parents.resize(nrOfCells);
+		m_Sizes.resize(nrOfCells);
+		Relabel();
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	int GridRegions<T_NodeType, T_ConnectionType>::Find(int idx) const
+	{
+		// path halving, every other cell on the way points to its grandparent
+		while (m_Parents[idx] != idx)
+		{
+			m_Parents[idx] = m_Parents[m_Parents[idx]];
+			idx = m_Parents[idx];
+		}
+		return idx;
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	void GridRegions<T_NodeType, T_ConnectionType>::Union(int idxA, int idxB) const
+	{
+		int rootA{ Find(idxA) };
+		int rootB{ Find(idxB) };
+		if (rootA == rootB)
+			return;
+
+		// the smaller tree goes under the larger one
+		if (m_Sizes[rootA] < m_Sizes[rootB])
+			std::swap(rootA, rootB);
+
+		m_Parents[rootB] = rootA;
+		m_Sizes[rootA] += m_Sizes[rootB];
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	void GridRegions<T_NodeType, T_ConnectionType>::Relabel() const
+	{
+		const int columns{ m_pGrid->GetColumns() };
+		const int rows{ m_pGrid->GetRows() };
+		const bool isConnectedDiagonally{ m_pGrid->IsConnectedDiagonally() };
+
+		// One pass in index order over the runs of passable cells in every row. The first cell of a run holds the others,
+		// the run joins every run of the row above it touches once, not every cell with every neighbor
+		for (int r = 0; r < rows; ++r)
+		{
+			int c{ 0 };
+			while (c < columns)
+			{
+				const int runStart{ r * columns + c };
+				if (!IsCellPassable(runStart))
+				{
+					m_Parents[runStart] = runStart;
+					m_Sizes[runStart] = 1;
+					++c;
+					continue;
+				}
+
+				int runEnd{ c };
+				while (runEnd + 1 < columns && IsCellPassable(runStart + runEnd + 1 - c))
+					++runEnd;
+
+				for (int idx = runStart; idx <= runStart + runEnd - c; ++idx)
+					m_Parents[idx] = runStart;
+				m_Sizes[runStart] = runEnd - c + 1;
+
+				if (r > 0)
+				{
+					const int above{ runStart - columns }; // the cell above the first one of the run
+					if (isConnectedDiagonally && c > 0 && IsCellPassable(above - 1))
+						Union(runStart, above - 1);
+
+					// the first cell of every run above that overlaps this one
+					for (int i = 0; i <= runEnd - c; ++i)
+					{
+						if (IsCellPassable(above + i) && (i == 0 || !IsCellPassable(above + i - 1)))
+							Union(runStart, above + i);
+					}
+
+					if (isConnectedDiagonally && runEnd + 1 < columns && IsCellPassable(above + runEnd + 1 - c) && !IsCellPassable(above + runEnd - c))
+						Union(runStart, above + runEnd + 1 - c);
+				}
+
+				c = runEnd + 1;
+			}
+		}
+
+		m_NeedsRelabel = false;
+		++m_NrOfRelabels;
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	bool GridRegions<T_NodeType, T_ConnectionType>::CanSplitRegion(int col, int row) const
+	{
+		// the 8 cells around the blocked one in order, straight ones on the even indices
+		static constexpr int columnOffsets[8]{ 1, 1, 0, -1, -1, -1, 0, 1 };
+		static constexpr int rowOffsets[8]{ 0, 1, 1, 1, 0, -1, -1, -1 };
+		const bool isConnectedDiagonally{ m_pGrid->IsConnectedDiagonally() };
+
+		bool isPassable[8]{};
+		for (int i = 0; i < 8; ++i)
+		{
+			const int c{ col + columnOffsets[i] };
+			const int r{ row + rowOffsets[i] };
+			isPassable[i] = m_pGrid->IsWithinBounds(c, r) && IsCellPassable(m_pGrid->GetIndex(c, r));
+		}
+
+		// Walk the ring and count the separate runs that hold a neighbor of the cell. Cells next to each other on the ring
+		// are straight neighbors, with diagonal connections two straight cells around a blocked corner touch as well.
+		const auto isBreak = [&](int i)
+		{
+			const bool isBridged{ isConnectedDiagonally && i % 2 == 1 && isPassable[(i + 7) % 8] && isPassable[(i + 1) % 8] };
+			return !isPassable[i] && !isBridged;
+		};
+
+		int start{ -1 };
+		for (int i = 0; i < 8 && start < 0; ++i)
+		{
+			if (isBreak(i))
+				start = i;
+		}
+		if (start < 0)
+			return false; // the whole ring hangs together
+
+		// the walk ends on the start cell, which closes the last run
+		int nrOfRuns{ 0 };
+		bool runHasNeighbor{ false };
+		for (int step = 1; step <= 8; ++step)
+		{
+			const int i{ (start + step) % 8 };
+			if (!isBreak(i))
+			{
+				runHasNeighbor = runHasNeighbor || (isPassable[i] && (i % 2 == 0 || isConnectedDiagonally));
+				continue;
+			}
+
+			if (runHasNeighbor)
+				++nrOfRuns;
+			runHasNeighbor = false;
+		}
+
+		return nrOfRuns > 1;
+	}
+}
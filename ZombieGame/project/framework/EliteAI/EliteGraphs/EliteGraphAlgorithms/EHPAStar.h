@@ -0,0 +1,664 @@
+#pragma once
+#include "../EGridGraph.h"
+#include "../EliteGraphUtilities/EGraphSearch.h"
+#include "EAStar.h"
+#include <cfloat>
+
+namespace Elite
+{
+	// Hierarchical A* (Botea, Muller & Schaeffer) over an undirected GridGraph. The grid is cut into square clusters, every
+	// run of open cells along the border of two clusters gets one or two transitions (the cells on either side of it) and
+	// the cost between the transition cells of a cluster is worked out once. On a grid connected diagonally, a diagonal
+	// crossing next to a closed one, and one over the corner of four clusters, gets a transition of its own. A query searches that small graph of
+	// transition cells and only then fills in the cells, one cluster at a time, so a long trip only pays for the clusters
+	// it walks through.
+	// The clusters are cached. OnCellChanged marks the clusters around an edited cell, only those get worked out again on
+	// the next query. An edit of the grid it isn't told about (see IGraph::GetRevision) rebuilds every cluster, so it's told
+	// how many edits a changed cell took.
+	// Directional grids go to a flat AStar, the costs into a cluster are taken to be the costs out of it.
+	template <class T_NodeType, class T_ConnectionType>
+	class HPAStar
+	{
+	public:
+		HPAStar(GridGraph<T_NodeType, T_ConnectionType>* pGrid, Heuristic hFunction, int clusterSize = 16);
+
+		// The nodes from start to goal, every cell along the way like AStar, empty if the goal can't be reached
+		std::vector<T_NodeType*> FindPath(T_NodeType* pStartNode, T_NodeType* pGoalNode);
+
+		// The route over the cluster graph only: start, the transition cells it passes and goal (false if there's none).
+		// Two waypoints in a row are in the same or neighboring clusters, RefineSegment fills in the cells between them when
+		// the agent gets there. A goal in a cluster next to the start's is looked for in those two clusters first, the
+		// route is just start and goal then: a short trip doesn't have to go through the transition cells.
+		bool FindAbstractPath(T_NodeType* pStartNode, T_NodeType* pGoalNode, std::vector<int>& waypoints);
+		// Adds the cells after fromIdx up to and including toIdx to path
+		bool RefineSegment(int fromIdx, int toIdx, std::vector<T_NodeType*>& path);
+
+		// To be called after the connections or costs of a cell changed, nrOfEdits being the calls that changed the graph for it
+		// (AddConnection, RemoveConnection, SetConnectionCost). Edits left out count as ones it wasn't told about
+		void OnCellChanged(int idx, unsigned int nrOfEdits = 1);
+
+		int GetClusterSize() const { return m_ClusterSize; }
+		int GetNrOfClusters() const { return static_cast<int>(m_Clusters.size()); }
+		int GetNrOfTransitionCells() const;
+
+	private:
+		struct Exit
+		{
+			int fromIdx; // transition cell of this cluster
+			int toIdx; // the one across the border
+			int toId; // its node id in the cluster graph
+			float cost;
+		};
+
+		struct Cluster
+		{
+			int minCol, minRow, maxCol, maxRow; // exclusive max
+			std::vector<int> transitionCells; // sorted
+			std::vector<float> costs; // from transition cell i to j within the cluster, FLT_MAX when there's no way
+			std::vector<Exit> exits; // sorted on fromIdx
+			std::vector<int> components; // per transition cell, the part of the cluster graph it's in
+			bool isDirty{ true };
+		};
+
+		struct NodeRecord
+		{
+			float costSoFar = 0.f;
+			float heuristicCost = 0.f;
+			int fromIdx = invalid_node_index; // the node id in the cluster graph
+		};
+
+		// runs shorter than this get one transition in their middle, longer ones one at either end
+		static const int m_MinRunForTwoTransitions{ 6 };
+
+		GridGraph<T_NodeType, T_ConnectionType>* m_pGrid;
+		Heuristic m_HeuristicFunction;
+		AStar<T_NodeType, T_ConnectionType> m_AStar;
+		int m_ClusterSize;
+		int m_NodeIdStride; // the most transition cells a cluster can have, one per cell along its border
+
+		std::vector<Cluster> m_Clusters;
+		int m_NrOfClusterColumns{ 0 };
+		int m_NrOfClusterRows{ 0 };
+		bool m_IsBuilt{ false };
+		bool m_IsLinked{ false };
+		unsigned int m_KnownRevision{ 0 };
+
+		// the search over the cluster graph, indexed by node id, and the searches within clusters, indexed by cell
+		SearchRecords<NodeRecord> m_Records;
+		NodeHeap<EstimatedCostKey> m_OpenList;
+		SearchRecords<NodeRecord> m_ClusterRecords;
+		NodeHeap<EstimatedCostKey> m_ClusterOpenList;
+		std::vector<float> m_StartCosts; // start to the transition cells of its cluster
+		std::vector<float> m_GoalCosts; // the transition cells of the goal's cluster to the goal
+
+		void UpdateClusters();
+		void BuildCluster(Cluster& cluster);
+		// Points the exits at the node ids across the border and flood fills the cluster graph into components,
+		// a goal outside the start's component is turned down without a search. False when an exit leads to a cell that
+		// isn't a transition cell across the border, the clusters on both sides are marked to be built again then
+		bool LinkClusters();
+		void AddTransitions(Cluster& cluster, int innerCol, int innerRow, int dAlongCol, int dAlongRow, int dOutCol, int dOutRow, int length);
+		// innerIdx becomes a transition cell when there's a connection between it and outerIdx either way
+		void AddTransition(Cluster& cluster, int innerIdx, int outerIdx);
+		// Dijkstra from sourceIdx over the cells of the cluster into m_ClusterRecords, A* that stops at targetIdx when it's given
+		void SearchCluster(const Cluster& cluster, int sourceIdx, int targetIdx = invalid_node_index)
+		{
+			SearchArea(cluster.minCol, cluster.minRow, cluster.maxCol, cluster.maxRow, sourceIdx, targetIdx);
+		}
+		// same, over the clusters of both cells, false if they aren't the same or neighbors
+		bool SearchNeighboringClusters(int sourceIdx, int targetIdx);
+		void SearchArea(int minCol, int minRow, int maxCol, int maxRow, int sourceIdx, int targetIdx);
+
+		int GetClusterIndex(int idx) const;
+		// invalid_node_index when idx isn't one of the cluster's transition cells
+		int GetTransitionIndex(const Cluster& cluster, int idx) const;
+		float GetConnectionCost(int fromIdx, int toIdx) const;
+		float GetHeuristicCost(int fromIdx, int toIdx) const;
+	};
+
+
+	template <class T_NodeType, class T_ConnectionType>
+	HPAStar<T_NodeType, T_ConnectionType>::HPAStar(GridGraph<T_NodeType, T_ConnectionType>* pGrid, Heuristic hFunction, int clusterSize)
+		: m_pGrid(pGrid)
+		, m_HeuristicFunction(hFunction)
+		, m_AStar(pGrid, hFunction)
+		, m_ClusterSize(max(clusterSize, 2))
+		, m_NodeIdStride(4 * m_ClusterSize)
+	{
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	std::vector<T_NodeType*> HPAStar<T_NodeType, T_ConnectionType>::FindPath(T_NodeType* pStartNode, T_NodeType* pGoalNode)
+	{
+		if (m_pGrid->IsDirectionalGraph())
+			return m_AStar.FindPath(pStartNode, pGoalNode);
+
+		std::vector<T_NodeType*> path;
+		std::vector<int> waypoints;
+		if (!FindAbstractPath(pStartNode, pGoalNode, waypoints))
+			return path;
+
+		path.push_back(pStartNode);
+		for (size_t i = 1; i < waypoints.size(); ++i)
+		{
+			if (!RefineSegment(waypoints[i - 1], waypoints[i], path))
+				return std::vector<T_NodeType*>();
+		}
+		return path;
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	bool HPAStar<T_NodeType, T_ConnectionType>::FindAbstractPath(T_NodeType* pStartNode, T_NodeType* pGoalNode, std::vector<int>& waypoints)
+	{
+		waypoints.clear();
+		if (!pStartNode || !pGoalNode || pStartNode->GetIndex() == invalid_node_index || pGoalNode->GetIndex() == invalid_node_index)
+			return false;
+
+		const int startIdx{ pStartNode->GetIndex() };
+		const int goalIdx{ pGoalNode->GetIndex() };
+		if (startIdx == goalIdx)
+		{
+			waypoints.push_back(startIdx);
+			return true;
+		}
+
+		UpdateClusters();
+
+		if (SearchNeighboringClusters(startIdx, goalIdx) && m_ClusterRecords.IsVisited(goalIdx))
+		{
+			waypoints.push_back(startIdx);
+			waypoints.push_back(goalIdx);
+			return true;
+		}
+
+		// start and goal join the cluster graph through the transition cells of their own cluster
+		const Cluster& startCluster{ m_Clusters[GetClusterIndex(startIdx)] };
+		const Cluster& goalCluster{ m_Clusters[GetClusterIndex(goalIdx)] };
+
+		SearchCluster(startCluster, startIdx);
+		m_StartCosts.assign(startCluster.transitionCells.size(), FLT_MAX);
+		for (size_t i = 0; i < startCluster.transitionCells.size(); ++i)
+		{
+			if (m_ClusterRecords.IsVisited(startCluster.transitionCells[i]))
+				m_StartCosts[i] = m_ClusterRecords.Get(startCluster.transitionCells[i]).costSoFar;
+		}
+
+		SearchCluster(goalCluster, goalIdx);
+		m_GoalCosts.assign(goalCluster.transitionCells.size(), FLT_MAX);
+		for (size_t i = 0; i < goalCluster.transitionCells.size(); ++i)
+		{
+			if (m_ClusterRecords.IsVisited(goalCluster.transitionCells[i]))
+				m_GoalCosts[i] = m_ClusterRecords.Get(goalCluster.transitionCells[i]).costSoFar;
+		}
+
+		bool isInSameComponent{ false };
+		for (size_t i = 0; i < m_StartCosts.size() && !isInSameComponent; ++i)
+		{
+			for (size_t j = 0; j < m_GoalCosts.size() && !isInSameComponent; ++j)
+			{
+				isInSameComponent = m_StartCosts[i] != FLT_MAX && m_GoalCosts[j] != FLT_MAX
+					&& startCluster.components[i] == goalCluster.components[j];
+			}
+		}
+		if (!isInSameComponent)
+			return false;
+
+		// the transition cells of a cluster get a block of node ids of their own, start and goal come after the last block
+		const int startId{ static_cast<int>(m_Clusters.size()) * m_NodeIdStride };
+		const int goalId{ startId + 1 };
+		const int startClusterIdx{ GetClusterIndex(startIdx) };
+		const int goalClusterIdx{ GetClusterIndex(goalIdx) };
+		m_Records.Begin(startId + 2);
+		m_OpenList.Begin(startId + 2);
+
+		NodeRecord& startRecord{ m_Records.Visit(startId) };
+		startRecord.heuristicCost = GetHeuristicCost(startIdx, goalIdx);
+		m_OpenList.Push(startId, { startRecord.heuristicCost, startRecord.heuristicCost });
+
+		const auto relax = [this, goalIdx](int fromId, float fromCost, int toId, int toIdx, float cost)
+		{
+			const float costSoFar{ fromCost + cost };
+			const bool isVisited{ m_Records.IsVisited(toId) };
+			if (isVisited && m_Records.Get(toId).costSoFar <= costSoFar)
+				return;
+
+			NodeRecord& record{ m_Records.Visit(toId) };
+			if (!isVisited)
+				record.heuristicCost = GetHeuristicCost(toIdx, goalIdx);
+			record.costSoFar = costSoFar;
+			record.fromIdx = fromId;
+			m_OpenList.Push(toId, { costSoFar + record.heuristicCost, record.heuristicCost });
+		};
+
+		bool isGoalReached{ false };
+		while (!m_OpenList.IsEmpty())
+		{
+			const int currentId{ m_OpenList.PopMin() };
+			if (currentId == goalId)
+			{
+				isGoalReached = true;
+				break;
+			}
+
+			const float currentCost{ m_Records.Get(currentId).costSoFar };
+			if (currentId == startId)
+			{
+				for (size_t i = 0; i < startCluster.transitionCells.size(); ++i)
+				{
+					if (m_StartCosts[i] != FLT_MAX)
+						relax(currentId, currentCost, startClusterIdx * m_NodeIdStride + static_cast<int>(i), startCluster.transitionCells[i], m_StartCosts[i]);
+				}
+				continue;
+			}
+
+			// a transition cell: the others of its cluster, across the border and the goal when it's in the same cluster
+			const int clusterIdx{ currentId / m_NodeIdStride };
+			const int transitionIdx{ currentId % m_NodeIdStride };
+			const Cluster& cluster{ m_Clusters[clusterIdx] };
+			const size_t nrOfTransitions{ cluster.transitionCells.size() };
+			for (size_t i = 0; i < nrOfTransitions; ++i)
+			{
+				const float cost{ cluster.costs[transitionIdx * nrOfTransitions + i] };
+				if (cost != FLT_MAX && static_cast<int>(i) != transitionIdx)
+					relax(currentId, currentCost, clusterIdx * m_NodeIdStride + static_cast<int>(i), cluster.transitionCells[i], cost);
+			}
+
+			const int currentIdx{ cluster.transitionCells[transitionIdx] };
+			const auto firstExit = std::lower_bound(cluster.exits.begin(), cluster.exits.end(), currentIdx,
+				[](const Exit& exit, int idx) { return exit.fromIdx < idx; });
+			for (auto it = firstExit; it != cluster.exits.end() && it->fromIdx == currentIdx; ++it)
+				relax(currentId, currentCost, it->toId, it->toIdx, it->cost);
+
+			if (clusterIdx == goalClusterIdx && m_GoalCosts[transitionIdx] != FLT_MAX)
+				relax(currentId, currentCost, goalId, goalIdx, m_GoalCosts[transitionIdx]);
+		}
+
+		if (!isGoalReached)
+			return false;
+
+		waypoints.push_back(goalIdx);
+		for (int id = m_Records.Get(goalId).fromIdx; id != startId; id = m_Records.Get(id).fromIdx)
+			waypoints.push_back(m_Clusters[id / m_NodeIdStride].transitionCells[id % m_NodeIdStride]);
+		waypoints.push_back(startIdx);
+		std::reverse(waypoints.begin(), waypoints.end());
+		return true;
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	bool HPAStar<T_NodeType, T_ConnectionType>::RefineSegment(int fromIdx, int toIdx, std::vector<T_NodeType*>& path)
+	{
+		UpdateClusters();
+
+		if (!SearchNeighboringClusters(fromIdx, toIdx) || !m_ClusterRecords.IsVisited(toIdx))
+			return false;
+
+		const size_t firstCell{ path.size() };
+		for (int idx = toIdx; idx != fromIdx; idx = m_ClusterRecords.Get(idx).fromIdx)
+			path.push_back(m_pGrid->GetNode(idx));
+		std::reverse(path.begin() + firstCell, path.end());
+		return true;
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	void HPAStar<T_NodeType, T_ConnectionType>::OnCellChanged(int idx, unsigned int nrOfEdits)
+	{
+		if (!m_IsBuilt)
+			return;
+
+		// the cell's own cluster, and the one across the border when the cell lies on it (its transitions are shared).
+		// A corner cell is also a transition of the cluster diagonally across, on a grid connected diagonally
+		const int col{ idx % m_pGrid->GetColumns() };
+		const int row{ idx / m_pGrid->GetColumns() };
+		const int clusterCol{ col / m_ClusterSize };
+		const int clusterRow{ row / m_ClusterSize };
+		const auto markDirty = [this](int clusterCol, int clusterRow)
+		{
+			if (clusterCol >= 0 && clusterCol < m_NrOfClusterColumns && clusterRow >= 0 && clusterRow < m_NrOfClusterRows)
+				m_Clusters[clusterRow * m_NrOfClusterColumns + clusterCol].isDirty = true;
+		};
+
+		const int dCol{ col % m_ClusterSize == 0 ? -1 : (col % m_ClusterSize == m_ClusterSize - 1 ? 1 : 0) };
+		const int dRow{ row % m_ClusterSize == 0 ? -1 : (row % m_ClusterSize == m_ClusterSize - 1 ? 1 : 0) };
+		markDirty(clusterCol, clusterRow);
+		if (dCol != 0)
+			markDirty(clusterCol + dCol, clusterRow);
+		if (dRow != 0)
+			markDirty(clusterCol, clusterRow + dRow);
+		if (dCol != 0 && dRow != 0)
+			markDirty(clusterCol + dCol, clusterRow + dRow);
+
+		// only the edits it's told about, any other one still shows up as a revision it doesn't know
+		m_KnownRevision += nrOfEdits;
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	int HPAStar<T_NodeType, T_ConnectionType>::GetNrOfTransitionCells() const
+	{
+		int nrOfTransitionCells{ 0 };
+		for (const Cluster& cluster : m_Clusters)
+			nrOfTransitionCells += static_cast<int>(cluster.transitionCells.size());
+		return nrOfTransitionCells;
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	void HPAStar<T_NodeType, T_ConnectionType>::UpdateClusters()
+	{
+		const int columns{ m_pGrid->GetColumns() };
+		const int rows{ m_pGrid->GetRows() };
+		const int nrOfClusterColumns{ (columns + m_ClusterSize - 1) / m_ClusterSize };
+		const int nrOfClusterRows{ (rows + m_ClusterSize - 1) / m_ClusterSize };
+
+		if (!m_IsBuilt || m_KnownRevision != m_pGrid->GetRevision()
+			|| nrOfClusterColumns != m_NrOfClusterColumns || nrOfClusterRows != m_NrOfClusterRows)
+		{
+			m_NrOfClusterColumns = nrOfClusterColumns;
+			m_NrOfClusterRows = nrOfClusterRows;
+			m_Clusters.assign(static_cast<size_t>(nrOfClusterColumns) * nrOfClusterRows, Cluster{});
+			for (int clusterRow = 0; clusterRow < nrOfClusterRows; ++clusterRow)
+			{
+				for (int clusterCol = 0; clusterCol < nrOfClusterColumns; ++clusterCol)
+				{
+					Cluster& cluster{ m_Clusters[clusterRow * nrOfClusterColumns + clusterCol] };
+					cluster.minCol = clusterCol * m_ClusterSize;
+					cluster.minRow = clusterRow * m_ClusterSize;
+					cluster.maxCol = min(cluster.minCol + m_ClusterSize, columns);
+					cluster.maxRow = min(cluster.minRow + m_ClusterSize, rows);
+				}
+			}
+
+			m_IsBuilt = true;
+			m_KnownRevision = m_pGrid->GetRevision();
+		}
+
+		// linking marks the clusters whose exits don't match the other side, those get built again
+		while (true)
+		{
+			for (Cluster& cluster : m_Clusters)
+			{
+				if (cluster.isDirty)
+				{
+					BuildCluster(cluster);
+					m_IsLinked = false;
+				}
+			}
+
+			if (m_IsLinked)
+				break;
+			m_IsLinked = LinkClusters();
+		}
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	bool HPAStar<T_NodeType, T_ConnectionType>::LinkClusters()
+	{
+		bool isLinked{ true };
+		for (Cluster& cluster : m_Clusters)
+		{
+			for (Exit& exit : cluster.exits)
+			{
+				const int otherClusterIdx{ GetClusterIndex(exit.toIdx) };
+				const int otherIdx{ GetTransitionIndex(m_Clusters[otherClusterIdx], exit.toIdx) };
+				assert(otherIdx != invalid_node_index && "<HPAStar::LinkClusters>: an exit leads to a cell that isn't a transition cell");
+				if (otherIdx == invalid_node_index)
+				{
+					cluster.isDirty = true;
+					m_Clusters[otherClusterIdx].isDirty = true;
+					isLinked = false;
+				}
+				exit.toId = otherClusterIdx * m_NodeIdStride + otherIdx;
+			}
+			cluster.components.assign(cluster.transitionCells.size(), invalid_node_index);
+		}
+		if (!isLinked)
+			return false;
+
+		// pairs of cluster and transition index
+		std::vector<std::pair<int, int>> stack;
+		int nrOfComponents{ 0 };
+		for (int clusterIdx = 0; clusterIdx < static_cast<int>(m_Clusters.size()); ++clusterIdx)
+		{
+			for (int transitionIdx = 0; transitionIdx < static_cast<int>(m_Clusters[clusterIdx].transitionCells.size()); ++transitionIdx)
+			{
+				if (m_Clusters[clusterIdx].components[transitionIdx] != invalid_node_index)
+					continue;
+
+				const int component{ nrOfComponents++ };
+				m_Clusters[clusterIdx].components[transitionIdx] = component;
+				stack.push_back({ clusterIdx, transitionIdx });
+				while (!stack.empty())
+				{
+					const int currentClusterIdx{ stack.back().first };
+					const int current{ stack.back().second };
+					stack.pop_back();
+
+					Cluster& cluster{ m_Clusters[currentClusterIdx] };
+					const size_t nrOfTransitions{ cluster.transitionCells.size() };
+					for (size_t i = 0; i < nrOfTransitions; ++i)
+					{
+						if (cluster.costs[current * nrOfTransitions + i] != FLT_MAX && cluster.components[i] == invalid_node_index)
+						{
+							cluster.components[i] = component;
+							stack.push_back({ currentClusterIdx, static_cast<int>(i) });
+						}
+					}
+
+					const int currentIdx{ cluster.transitionCells[current] };
+					const auto firstExit = std::lower_bound(cluster.exits.begin(), cluster.exits.end(), currentIdx,
+						[](const Exit& exit, int idx) { return exit.fromIdx < idx; });
+					for (auto it = firstExit; it != cluster.exits.end() && it->fromIdx == currentIdx; ++it)
+					{
+						const int otherClusterIdx{ it->toId / m_NodeIdStride };
+						const int otherIdx{ it->toId % m_NodeIdStride };
+						Cluster& otherCluster{ m_Clusters[otherClusterIdx] };
+						if (otherCluster.components[otherIdx] == invalid_node_index)
+						{
+							otherCluster.components[otherIdx] = component;
+							stack.push_back({ otherClusterIdx, otherIdx });
+						}
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	void HPAStar<T_NodeType, T_ConnectionType>::BuildCluster(Cluster& cluster)
+	{
+		cluster.isDirty = false;
+		cluster.transitionCells.clear();
+		cluster.exits.clear();
+
+		const int width{ cluster.maxCol - cluster.minCol };
+		const int height{ cluster.maxRow - cluster.minRow };
+		if (cluster.minCol > 0) // left
+			AddTransitions(cluster, cluster.minCol, cluster.minRow, 0, 1, -1, 0, height);
+		if (cluster.maxCol < m_pGrid->GetColumns()) // right
+			AddTransitions(cluster, cluster.maxCol - 1, cluster.minRow, 0, 1, 1, 0, height);
+		if (cluster.minRow > 0) // top
+			AddTransitions(cluster, cluster.minCol, cluster.minRow, 1, 0, 0, -1, width);
+		if (cluster.maxRow < m_pGrid->GetRows()) // bottom
+			AddTransitions(cluster, cluster.minCol, cluster.maxRow - 1, 1, 0, 0, 1, width);
+
+		// the corners can only be crossed diagonally, into the cluster they share nothing but that corner with
+		if (m_pGrid->IsConnectedDiagonally())
+		{
+			const int lastCol{ cluster.maxCol - 1 };
+			const int lastRow{ cluster.maxRow - 1 };
+			const auto addCorner = [&](int col, int row, int dCol, int dRow)
+			{
+				if (m_pGrid->IsWithinBounds(col + dCol, row + dRow))
+					AddTransition(cluster, m_pGrid->GetIndex(col, row), m_pGrid->GetIndex(col + dCol, row + dRow));
+			};
+			addCorner(cluster.minCol, cluster.minRow, -1, -1);
+			addCorner(lastCol, cluster.minRow, 1, -1);
+			addCorner(cluster.minCol, lastRow, -1, 1);
+			addCorner(lastCol, lastRow, 1, 1);
+		}
+
+		// a corner cell can be a transition cell of two borders
+		std::sort(cluster.transitionCells.begin(), cluster.transitionCells.end());
+		cluster.transitionCells.erase(std::unique(cluster.transitionCells.begin(), cluster.transitionCells.end()), cluster.transitionCells.end());
+		std::sort(cluster.exits.begin(), cluster.exits.end(), [](const Exit& a, const Exit& b) { return a.fromIdx < b.fromIdx; });
+
+		const size_t nrOfTransitions{ cluster.transitionCells.size() };
+		cluster.costs.assign(nrOfTransitions * nrOfTransitions, FLT_MAX);
+		for (size_t i = 0; i < nrOfTransitions; ++i)
+		{
+			SearchCluster(cluster, cluster.transitionCells[i]);
+			for (size_t j = 0; j < nrOfTransitions; ++j)
+			{
+				if (m_ClusterRecords.IsVisited(cluster.transitionCells[j]))
+					cluster.costs[i * nrOfTransitions + j] = m_ClusterRecords.Get(cluster.transitionCells[j]).costSoFar;
+			}
+		}
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	void HPAStar<T_NodeType, T_ConnectionType>::AddTransitions(Cluster& cluster, int innerCol, int innerRow, int dAlongCol, int dAlongRow, int dOutCol, int dOutRow, int length)
+	{
+		// Both clusters of a border find the same runs and transitions here, each keeping its own side of them
+		const auto getInnerIdx = [&](int i) { return m_pGrid->GetIndex(innerCol + i * dAlongCol, innerRow + i * dAlongRow); };
+		const auto getOuterIdx = [&](int i) { return m_pGrid->GetIndex(innerCol + i * dAlongCol + dOutCol, innerRow + i * dAlongRow + dOutRow); };
+		const auto isOpen = [&](int i)
+		{
+			return GetConnectionCost(getInnerIdx(i), getOuterIdx(i)) != FLT_MAX || GetConnectionCost(getOuterIdx(i), getInnerIdx(i)) != FLT_MAX;
+		};
+		const auto addTransition = [&](int i) { AddTransition(cluster, getInnerIdx(i), getOuterIdx(i)); };
+
+		int runStart{ -1 };
+		for (int i = 0; i <= length; ++i)
+		{
+			const bool isCellOpen{ i < length && isOpen(i) };
+			if (isCellOpen && runStart < 0)
+				runStart = i;
+
+			if (!isCellOpen && runStart >= 0)
+			{
+				const int runEnd{ i - 1 };
+				if (runEnd - runStart + 1 < m_MinRunForTwoTransitions)
+				{
+					addTransition((runStart + runEnd) / 2);
+				}
+				else
+				{
+					addTransition(runStart);
+					addTransition(runEnd);
+				}
+				runStart = -1;
+			}
+		}
+
+		// Where a position is closed straight across, the way over can still be a diagonal step to the position next to it.
+		// Looked at per pair of positions, which is the same pair seen from the other cluster, so both add their side
+		if (!m_pGrid->IsConnectedDiagonally())
+			return;
+
+		for (int i = 0; i + 1 < length; ++i)
+		{
+			if (isOpen(i) && isOpen(i + 1))
+				continue;
+
+			AddTransition(cluster, getInnerIdx(i), getOuterIdx(i + 1));
+			AddTransition(cluster, getInnerIdx(i + 1), getOuterIdx(i));
+		}
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	void HPAStar<T_NodeType, T_ConnectionType>::AddTransition(Cluster& cluster, int innerIdx, int outerIdx)
+	{
+		// a one way connection still makes it a transition, the cluster across needs it to get out this way
+		const float cost{ GetConnectionCost(innerIdx, outerIdx) };
+		if (cost == FLT_MAX && GetConnectionCost(outerIdx, innerIdx) == FLT_MAX)
+			return;
+
+		cluster.transitionCells.push_back(innerIdx);
+		if (cost != FLT_MAX)
+			cluster.exits.push_back({ innerIdx, outerIdx, invalid_node_index, cost });
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	bool HPAStar<T_NodeType, T_ConnectionType>::SearchNeighboringClusters(int sourceIdx, int targetIdx)
+	{
+		const Cluster& sourceCluster{ m_Clusters[GetClusterIndex(sourceIdx)] };
+		const Cluster& targetCluster{ m_Clusters[GetClusterIndex(targetIdx)] };
+		if (std::abs(sourceCluster.minCol - targetCluster.minCol) > m_ClusterSize || std::abs(sourceCluster.minRow - targetCluster.minRow) > m_ClusterSize)
+			return false;
+
+		SearchArea(min(sourceCluster.minCol, targetCluster.minCol), min(sourceCluster.minRow, targetCluster.minRow),
+			max(sourceCluster.maxCol, targetCluster.maxCol), max(sourceCluster.maxRow, targetCluster.maxRow), sourceIdx, targetIdx);
+		return true;
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	void HPAStar<T_NodeType, T_ConnectionType>::SearchArea(int minCol, int minRow, int maxCol, int maxRow, int sourceIdx, int targetIdx)
+	{
+		const int columns{ m_pGrid->GetColumns() };
+		m_ClusterRecords.Begin(m_pGrid->GetNrOfNodes());
+		m_ClusterOpenList.Begin(m_pGrid->GetNrOfNodes());
+
+		m_ClusterRecords.Visit(sourceIdx);
+		m_ClusterOpenList.Push(sourceIdx, { 0.f, 0.f });
+		while (!m_ClusterOpenList.IsEmpty())
+		{
+			const int currentIdx{ m_ClusterOpenList.PopMin() };
+			if (currentIdx == targetIdx)
+				return;
+
+			const float currentCost{ m_ClusterRecords.Get(currentIdx).costSoFar };
+			for (const auto neighbor : m_pGrid->GetNeighbors(currentIdx))
+			{
+				const int col{ neighbor.to % columns };
+				const int row{ neighbor.to / columns };
+				if (col < minCol || col >= maxCol || row < minRow || row >= maxRow)
+					continue;
+
+				const float costSoFar{ currentCost + neighbor.cost };
+				const bool isVisited{ m_ClusterRecords.IsVisited(neighbor.to) };
+				if (isVisited && m_ClusterRecords.Get(neighbor.to).costSoFar <= costSoFar)
+					continue;
+
+				NodeRecord& record{ m_ClusterRecords.Visit(neighbor.to) };
+				if (!isVisited && targetIdx != invalid_node_index)
+					record.heuristicCost = GetHeuristicCost(neighbor.to, targetIdx);
+				record.costSoFar = costSoFar;
+				record.fromIdx = currentIdx;
+				m_ClusterOpenList.Push(neighbor.to, { costSoFar + record.heuristicCost, record.heuristicCost });
+			}
+		}
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	int HPAStar<T_NodeType, T_ConnectionType>::GetClusterIndex(int idx) const
+	{
+		const int columns{ m_pGrid->GetColumns() };
+		return (idx / columns / m_ClusterSize) * m_NrOfClusterColumns + (idx % columns) / m_ClusterSize;
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	int HPAStar<T_NodeType, T_ConnectionType>::GetTransitionIndex(const Cluster& cluster, int idx) const
+	{
+		const auto it = std::lower_bound(cluster.transitionCells.begin(), cluster.transitionCells.end(), idx);
+		if (it == cluster.transitionCells.end() || *it != idx)
+			return invalid_node_index;
+		return static_cast<int>(it - cluster.transitionCells.begin());
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	float HPAStar<T_NodeType, T_ConnectionType>::GetConnectionCost(int fromIdx, int toIdx) const
+	{
+		for (const auto neighbor : m_pGrid->GetNeighbors(fromIdx))
+		{
+			if (neighbor.to == toIdx)
+				return neighbor.cost;
+		}
+		return FLT_MAX;
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	float HPAStar<T_NodeType, T_ConnectionType>::GetHeuristicCost(int fromIdx, int toIdx) const
+	{
+		const int columns{ m_pGrid->GetColumns() };
+		return m_HeuristicFunction(static_cast<float>(std::abs(toIdx % columns - fromIdx % columns)), static_cast<float>(std::abs(toIdx / columns - fromIdx / columns)));
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cmath>
+
+namespace Elite
+{
+	// Estimate of the cost between two nodes from the absolute difference of their positions along x and y
+	typedef float(*Heuristic)(float, float);
+
+	namespace HeuristicFunctions
+	{
+		// Grids that only connect straight
+		inline float Manhattan(float x, float y)
+		{
+			return x + y;
+		}
+
+		// Any graph whose connections cost their length
+		inline float Euclidean(float x, float y)
+		{
+			return std::sqrt(x * x + y * y);
+		}
+
+		// Grids with diagonal connections: the diagonal steps first, then straight ahead
+		inline float Octile(float x, float y)
+		{
+			const float diagonalExtra{ 0.414213562f }; // sqrt(2) - 1
+			return (x < y) ? diagonalExtra * x + y : diagonalExtra * y + x;
+		}
+
+		// Grids with GridGraph's default costs, a diagonal step costs one and a half straight ones
+		inline float GridOctile(float x, float y)
+		{
+			const float diagonalExtra{ .5f }; // 1.5 - 1
+			return (x < y) ? diagonalExtra * x + y : diagonalExtra * y + x;
+		}
+
+		// Grids where a diagonal step costs as much as a straight one
+		inline float Chebyshev(float x, float y)
+		{
+			return (x > y) ? x : y;
+		}
+	}
+}
@@ -0,0 +1,356 @@
+#pragma once
+#include "../EGridGraph.h"
+#include "../EliteGraphUtilities/EGraphSearch.h"
+#include "EAStar.h"
+#include <cstdint>
+
+namespace Elite
+{
+	// Jump Point Search (Harabor & Grastien) over a diagonally connected GridGraph. Instead of pushing every neighbor it
+	// scans along straight and diagonal lines and only stops at the cells where an obstacle forces a turn, so open terrain
+	// costs a few scans instead of thousands of open list entries. It finds the same cost paths as AStar, but only holds
+	// when the grid is uniform: a cell is either walkable or not, every pair of walkable neighbors is connected and the
+	// connections cost the grid's straight and diagonal defaults (with straight <= diagonal <= 2 * straight).
+	// Whether the grid still is gets checked again after it's edited (see IGraph::GetRevision), FindPath hands over to
+	// AStar when it isn't.
+	template <class T_NodeType, class T_ConnectionType>
+	class JumpPointSearch
+	{
+	public:
+		JumpPointSearch(GridGraph<T_NodeType, T_ConnectionType>* pGrid, Heuristic hFunction);
+
+		// The nodes from start to goal, every cell along the way like AStar, empty if the goal can't be reached
+		std::vector<T_NodeType*> FindPath(T_NodeType* pStartNode, T_NodeType* pGoalNode);
+
+		// false when FindPath falls back to AStar because the grid's costs aren't uniform
+		bool CanJump();
+
+	private:
+		struct NodeRecord
+		{
+			float costSoFar = 0.f;
+			float heuristicCost = 0.f;
+			int fromIdx = invalid_node_index; // the previous jump point, the cells in between lie on a straight or diagonal line
+		};
+
+		GridGraph<T_NodeType, T_ConnectionType>* m_pGrid;
+		Heuristic m_HeuristicFunction;
+		AStar<T_NodeType, T_ConnectionType> m_AStar;
+
+		SearchRecords<NodeRecord> m_Records;
+		NodeHeap<EstimatedCostKey> m_OpenList;
+
+		// Walkable cells of the grid with a blocked border around it, so the scans stop at the edge without bounds checks
+		std::vector<uint8_t> m_IsWalkable;
+		int m_PaddedColumns{ 0 };
+		bool m_IsUniform{ false };
+		bool m_IsGridChecked{ false };
+		unsigned int m_CheckedRevision{ 0 };
+
+		void CheckGrid();
+		bool IsWalkable(int col, int row) const { return m_IsWalkable[(row + 1) * m_PaddedColumns + col + 1] != 0; }
+		// The first jump point from (col, row) in direction (dCol, dRow), invalid_node_index if the scan runs into a wall
+		int Jump(int col, int row, int dCol, int dRow, int goalIdx) const;
+		int JumpStraight(int col, int row, int dCol, int dRow, int goalIdx) const;
+		float GetCost(int fromIdx, int toIdx) const;
+		float GetHeuristicCost(int fromIdx, int toIdx) const;
+	};
+
+
+	template <class T_NodeType, class T_ConnectionType>
+	JumpPointSearch<T_NodeType, T_ConnectionType>::JumpPointSearch(GridGraph<T_NodeType, T_ConnectionType>* pGrid, Heuristic hFunction)
+		: m_pGrid(pGrid)
+		, m_HeuristicFunction(hFunction)
+		, m_AStar(pGrid, hFunction)
+	{
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	bool JumpPointSearch<T_NodeType, T_ConnectionType>::CanJump()
+	{
+		if (!m_IsGridChecked || m_CheckedRevision != m_pGrid->GetRevision())
+			CheckGrid();
+		return m_IsUniform;
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	std::vector<T_NodeType*> JumpPointSearch<T_NodeType, T_ConnectionType>::FindPath(T_NodeType* pStartNode, T_NodeType* pGoalNode)
+	{
+		if (!CanJump())
+			return m_AStar.FindPath(pStartNode, pGoalNode);
+
+		std::vector<T_NodeType*> path;
+		if (!pStartNode || !pGoalNode || pStartNode->GetIndex() == invalid_node_index || pGoalNode->GetIndex() == invalid_node_index)
+			return path;
+
+		const int columns{ m_pGrid->GetColumns() };
+		const int startIdx{ pStartNode->GetIndex() };
+		const int goalIdx{ pGoalNode->GetIndex() };
+		if (startIdx != goalIdx && !IsWalkable(startIdx % columns, startIdx / columns))
+			return path;
+
+		m_Records.Begin(m_pGrid->GetNrOfNodes());
+		m_OpenList.Begin(m_pGrid->GetNrOfNodes());
+
+		NodeRecord& startRecord{ m_Records.Visit(startIdx) };
+		startRecord.heuristicCost = GetHeuristicCost(startIdx, goalIdx);
+		m_OpenList.Push(startIdx, { startRecord.heuristicCost, startRecord.heuristicCost });
+
+		bool isGoalReached{ startIdx == goalIdx };
+		while (!isGoalReached && !m_OpenList.IsEmpty())
+		{
+			const int currentIdx{ m_OpenList.PopMin() };
+			if (currentIdx == goalIdx)
+			{
+				isGoalReached = true;
+				break;
+			}
+
+			const NodeRecord current{ m_Records.Get(currentIdx) };
+			const int col{ currentIdx % columns };
+			const int row{ currentIdx / columns };
+
+			// the directions worth scanning, pruned by the direction we came from
+			int directions[8][2]{};
+			int nrOfDirections{ 0 };
+			const auto addDirection = [&](int dCol, int dRow)
+			{
+				if (IsWalkable(col + dCol, row + dRow))
+				{
+					directions[nrOfDirections][0] = dCol;
+					directions[nrOfDirections][1] = dRow;
+					++nrOfDirections;
+				}
+			};
+
+			if (current.fromIdx == invalid_node_index)
+			{
+				for (int dRow = -1; dRow <= 1; ++dRow)
+				{
+					for (int dCol = -1; dCol <= 1; ++dCol)
+					{
+						if (dCol != 0 || dRow != 0)
+							addDirection(dCol, dRow);
+					}
+				}
+			}
+			else
+			{
+				const int fromCol{ current.fromIdx % columns };
+				const int fromRow{ current.fromIdx / columns };
+				const int dCol{ (col > fromCol) - (col < fromCol) };
+				const int dRow{ (row > fromRow) - (row < fromRow) };
+
+				if (dCol != 0 && dRow != 0)
+				{
+					addDirection(dCol, 0);
+					addDirection(0, dRow);
+					addDirection(dCol, dRow);
+					// forced: a wall beside the diagonal opens up the cell behind it
+					if (!IsWalkable(col - dCol, row))
+						addDirection(-dCol, dRow);
+					if (!IsWalkable(col, row - dRow))
+						addDirection(dCol, -dRow);
+				}
+				else if (dCol != 0)
+				{
+					addDirection(dCol, 0);
+					if (!IsWalkable(col, row + 1))
+						addDirection(dCol, 1);
+					if (!IsWalkable(col, row - 1))
+						addDirection(dCol, -1);
+				}
+				else
+				{
+					addDirection(0, dRow);
+					if (!IsWalkable(col + 1, row))
+						addDirection(1, dRow);
+					if (!IsWalkable(col - 1, row))
+						addDirection(-1, dRow);
+				}
+			}
+
+			for (int i = 0; i < nrOfDirections; ++i)
+			{
+				const int jumpIdx{ Jump(col, row, directions[i][0], directions[i][1], goalIdx) };
+				if (jumpIdx == invalid_node_index)
+					continue;
+
+				const float costSoFar{ current.costSoFar + GetCost(currentIdx, jumpIdx) };
+				const bool isVisited{ m_Records.IsVisited(jumpIdx) };
+				if (isVisited && m_Records.Get(jumpIdx).costSoFar <= costSoFar)
+					continue;
+
+				NodeRecord& record{ m_Records.Visit(jumpIdx) };
+				if (!isVisited)
+					record.heuristicCost = GetHeuristicCost(jumpIdx, goalIdx);
+				record.costSoFar = costSoFar;
+				record.fromIdx = currentIdx;
+				m_OpenList.Push(jumpIdx, { costSoFar + record.heuristicCost, record.heuristicCost });
+			}
+		}
+
+		if (!isGoalReached)
+			return path;
+
+		// walk back over the jump points, filling in the cells between them
+		for (int idx = goalIdx; idx != startIdx; idx = m_Records.Get(idx).fromIdx)
+		{
+			const int fromIdx{ m_Records.Get(idx).fromIdx };
+			const int dCol{ (fromIdx % columns > idx % columns) - (fromIdx % columns < idx % columns) };
+			const int dRow{ (fromIdx / columns > idx / columns) - (fromIdx / columns < idx / columns) };
+			for (int cell = idx; cell != fromIdx; cell += dRow * columns + dCol)
+				path.push_back(m_pGrid->GetNode(cell));
+		}
+		path.push_back(pStartNode);
+
+		std::reverse(path.begin(), path.end());
+		return path;
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	void JumpPointSearch<T_NodeType, T_ConnectionType>::CheckGrid()
+	{
+		m_IsGridChecked = true;
+		m_CheckedRevision = m_pGrid->GetRevision();
+
+		const int columns{ m_pGrid->GetColumns() };
+		const int rows{ m_pGrid->GetRows() };
+		const float costStraight{ m_pGrid->GetDefaultCostStraight() };
+		const float costDiagonal{ m_pGrid->GetDefaultCostDiagonal() };
+		m_PaddedColumns = columns + 2;
+		m_IsWalkable.assign(static_cast<size_t>(m_PaddedColumns) * (rows + 2), 0);
+
+		m_IsUniform = m_pGrid->IsConnectedDiagonally()
+			&& costStraight <= costDiagonal && costDiagonal <= 2.f * costStraight
+			&& m_pGrid->GetNrOfNodes() == columns * rows;
+		if (!m_IsUniform)
+			return;
+
+		// a cell is walkable when it can be left, a cell without connections can't be entered either
+		for (int row = 0; row < rows; ++row)
+		{
+			for (int col = 0; col < columns; ++col)
+			{
+				const int idx{ m_pGrid->GetIndex(col, row) };
+				m_IsWalkable[(row + 1) * m_PaddedColumns + col + 1] = m_pGrid->IsNodeValid(idx) && !m_pGrid->GetNeighbors(idx).empty();
+			}
+		}
+
+		// uniform means the connections are exactly the ones between walkable neighbors, with the default costs
+		for (int row = 0; row < rows && m_IsUniform; ++row)
+		{
+			for (int col = 0; col < columns && m_IsUniform; ++col)
+			{
+				if (!IsWalkable(col, row))
+					continue;
+
+				int nrOfWalkableNeighbors{ 0 };
+				for (int dRow = -1; dRow <= 1; ++dRow)
+				{
+					for (int dCol = -1; dCol <= 1; ++dCol)
+					{
+						if ((dCol != 0 || dRow != 0) && IsWalkable(col + dCol, row + dRow))
+							++nrOfWalkableNeighbors;
+					}
+				}
+
+				const auto neighbors = m_pGrid->GetNeighbors(m_pGrid->GetIndex(col, row));
+				if (neighbors.size() != nrOfWalkableNeighbors)
+				{
+					m_IsUniform = false;
+					break;
+				}
+
+				for (const auto neighbor : neighbors)
+				{
+					const int dCol{ neighbor.to % columns - col };
+					const int dRow{ neighbor.to / columns - row };
+					const bool isAdjacent{ dCol >= -1 && dCol <= 1 && dRow >= -1 && dRow <= 1 };
+					if (!isAdjacent || !IsWalkable(col + dCol, row + dRow)
+						|| neighbor.cost != (dCol != 0 && dRow != 0 ? costDiagonal : costStraight))
+					{
+						m_IsUniform = false;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	int JumpPointSearch<T_NodeType, T_ConnectionType>::Jump(int col, int row, int dCol, int dRow, int goalIdx) const
+	{
+		if (dCol == 0 || dRow == 0)
+			return JumpStraight(col, row, dCol, dRow, goalIdx);
+
+		while (true)
+		{
+			col += dCol;
+			row += dRow;
+			if (!IsWalkable(col, row))
+				return invalid_node_index;
+
+			const int idx{ m_pGrid->GetIndex(col, row) };
+			if (idx == goalIdx)
+				return idx;
+
+			// forced neighbors, diagonal moves may cut the corner of a wall
+			if ((!IsWalkable(col - dCol, row) && IsWalkable(col - dCol, row + dRow))
+				|| (!IsWalkable(col, row - dRow) && IsWalkable(col + dCol, row - dRow)))
+				return idx;
+
+			// a jump point along either straight part makes this cell one too
+			if (JumpStraight(col, row, dCol, 0, goalIdx) != invalid_node_index
+				|| JumpStraight(col, row, 0, dRow, goalIdx) != invalid_node_index)
+				return idx;
+		}
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	int JumpPointSearch<T_NodeType, T_ConnectionType>::JumpStraight(int col, int row, int dCol, int dRow, int goalIdx) const
+	{
+		while (true)
+		{
+			col += dCol;
+			row += dRow;
+			if (!IsWalkable(col, row))
+				return invalid_node_index;
+
+			const int idx{ m_pGrid->GetIndex(col, row) };
+			if (idx == goalIdx)
+				return idx;
+
+			// forced neighbors: a wall beside the scan that ends, the diagonal past it can be a shortcut
+			if (dCol != 0)
+			{
+				if ((!IsWalkable(col, row + 1) && IsWalkable(col + dCol, row + 1))
+					|| (!IsWalkable(col, row - 1) && IsWalkable(col + dCol, row - 1)))
+					return idx;
+			}
+			else
+			{
+				if ((!IsWalkable(col + 1, row) && IsWalkable(col + 1, row + dRow))
+					|| (!IsWalkable(col - 1, row) && IsWalkable(col - 1, row + dRow)))
+					return idx;
+			}
+		}
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	float JumpPointSearch<T_NodeType, T_ConnectionType>::GetCost(int fromIdx, int toIdx) const
+	{
+		// jump points lie on a straight or diagonal line from each other
+		const int columns{ m_pGrid->GetColumns() };
+		const int nrOfSteps{ max(std::abs(toIdx % columns - fromIdx % columns), std::abs(toIdx / columns - fromIdx / columns)) };
+		const bool isDiagonal{ toIdx % columns != fromIdx % columns && toIdx / columns != fromIdx / columns };
+		return nrOfSteps * (isDiagonal ? m_pGrid->GetDefaultCostDiagonal() : m_pGrid->GetDefaultCostStraight());
+	}
+
+	template <class T_NodeType, class T_ConnectionType>
+	float JumpPointSearch<T_NodeType, T_ConnectionType>::GetHeuristicCost(int fromIdx, int toIdx) const
+	{
+		const int columns{ m_pGrid->GetColumns() };
+		return m_HeuristicFunction(static_cast<float>(std::abs(toIdx % columns - fromIdx % columns)), static_cast<float>(std::abs(toIdx / columns - fromIdx / columns)));
+	}
+}
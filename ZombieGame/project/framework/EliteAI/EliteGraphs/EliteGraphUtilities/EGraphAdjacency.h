@@ -0,0 +1,182 @@
+#pragma once
+#include <vector>
+
+namespace Elite
+{
+	// Compressed sparse row copy of a graph's connections: the to-indices and costs of every node sit in one run of two
+	// contiguous arrays, so walking the neighbors of a node is a linear read instead of chasing list nodes.
+	// Build fills it in one pass. The edits after that go into the arrays as well: a removal swaps the last connection of
+	// the run into its place, an addition uses the room a removal left or moves the run to the end of the arrays with
+	// room to spare. Compact closes the holes the moved runs leave behind, it runs by itself once they take up half the arrays.
+	class GraphAdjacency final
+	{
+	public:
+		struct Neighbor
+		{
+			int to;
+			float cost;
+		};
+
+		// The connections of one node, only valid until the next edit
+		class NeighborSpan final
+		{
+		public:
+			class Iterator final
+			{
+			public:
+				Iterator(const int* pTo, const float* pCost) : m_pTo(pTo), m_pCost(pCost) {}
+				Neighbor operator*() const { return { *m_pTo, *m_pCost }; }
+				Iterator& operator++() { ++m_pTo; ++m_pCost; return *this; }
+				bool operator!=(const Iterator& other) const { return m_pTo != other.m_pTo; }
+
+			private:
+				const int* m_pTo;
+				const float* m_pCost;
+			};
+
+			NeighborSpan(const int* pTo, const float* pCosts, int size) : m_pTo(pTo), m_pCosts(pCosts), m_Size(size) {}
+			Iterator begin() const { return { m_pTo, m_pCosts }; }
+			Iterator end() const { return { m_pTo + m_Size, m_pCosts + m_Size }; }
+			int size() const { return m_Size; }
+			bool empty() const { return m_Size == 0; }
+			Neighbor operator[](int i) const { return { m_pTo[i], m_pCosts[i] }; }
+
+			const int* GetToIndices() const { return m_pTo; }
+			const float* GetCosts() const { return m_pCosts; }
+
+		private:
+			const int* m_pTo;
+			const float* m_pCosts;
+			int m_Size;
+		};
+
+		// visitConnections(idx, add) has to call add(to, cost) for every connection of node idx, the nodes are visited in order
+		template <typename T_Visit>
+		void Build(int nrOfNodes, T_Visit visitConnections);
+
+		NeighborSpan GetNeighbors(int idx) const { return { m_To.data() + m_Begin[idx], m_Costs.data() + m_Begin[idx], m_Count[idx] }; }
+		int GetNrOfNodes() const { return static_cast<int>(m_Begin.size()); }
+		int GetNrOfConnections() const { return m_NrOfConnections; }
+
+		// Edits of a single connection, the connection the edit is about is looked up in the run of from
+		void AddConnection(int from, int to, float cost);
+		void RemoveConnection(int from, int to);
+		void SetConnectionCost(int from, int to, float cost);
+		void Compact();
+
+	private:
+		std::vector<int> m_Begin; // per node, where its run starts
+		std::vector<int> m_Count; // per node, the connections in its run
+		std::vector<int> m_Capacity; // per node, the room its run has
+		std::vector<int> m_To;
+		std::vector<float> m_Costs;
+		int m_NrOfConnections{ 0 };
+		int m_NrOfUnusedSlots{ 0 }; // left behind by runs that moved to the end
+
+		int FindConnection(int from, int to) const;
+	};
+
+	template <typename T_Visit>
+	void GraphAdjacency::Build(int nrOfNodes, T_Visit visitConnections)
+	{
+		m_Begin.resize(nrOfNodes);
+		m_Count.resize(nrOfNodes);
+		m_Capacity.resize(nrOfNodes);
+		m_To.clear();
+		m_Costs.clear();
+
+		for (int idx = 0; idx < nrOfNodes; ++idx)
+		{
+			m_Begin[idx] = static_cast<int>(m_To.size());
+			visitConnections(idx, [this](int to, float cost)
+				{
+					m_To.push_back(to);
+					m_Costs.push_back(cost);
+				});
+			m_Count[idx] = static_cast<int>(m_To.size()) - m_Begin[idx];
+			m_Capacity[idx] = m_Count[idx];
+		}
+
+		m_NrOfConnections = static_cast<int>(m_To.size());
+		m_NrOfUnusedSlots = 0;
+	}
+
+	inline void GraphAdjacency::AddConnection(int from, int to, float cost)
+	{
+		if (m_Count[from] == m_Capacity[from])
+		{
+			// Move the run to the end with room to grow, its old slots stay unused until the next Compact
+			const int newBegin{ static_cast<int>(m_To.size()) };
+			const int newCapacity{ m_Capacity[from] < 2 ? 4 : m_Capacity[from] * 2 };
+			m_To.resize(newBegin + newCapacity);
+			m_Costs.resize(newBegin + newCapacity);
+			for (int i = 0; i < m_Count[from]; ++i)
+			{
+				m_To[newBegin + i] = m_To[m_Begin[from] + i];
+				m_Costs[newBegin + i] = m_Costs[m_Begin[from] + i];
+			}
+
+			m_NrOfUnusedSlots += m_Capacity[from];
+			m_Begin[from] = newBegin;
+			m_Capacity[from] = newCapacity;
+		}
+
+		const int slot{ m_Begin[from] + m_Count[from]++ };
+		m_To[slot] = to;
+		m_Costs[slot] = cost;
+		++m_NrOfConnections;
+
+		if (m_NrOfUnusedSlots > static_cast<int>(m_To.size()) / 2)
+			Compact();
+	}
+
+	inline void GraphAdjacency::RemoveConnection(int from, int to)
+	{
+		const int slot{ FindConnection(from, to) };
+		if (slot < 0)
+			return;
+
+		// the order within a run doesn't matter, the last one fills the gap
+		const int last{ m_Begin[from] + --m_Count[from] };
+		m_To[slot] = m_To[last];
+		m_Costs[slot] = m_Costs[last];
+		--m_NrOfConnections;
+	}
+
+	inline void GraphAdjacency::SetConnectionCost(int from, int to, float cost)
+	{
+		const int slot{ FindConnection(from, to) };
+		if (slot >= 0)
+			m_Costs[slot] = cost;
+	}
+
+	inline void GraphAdjacency::Compact()
+	{
+		std::vector<int> to;
+		std::vector<float> costs;
+		to.reserve(m_NrOfConnections);
+		costs.reserve(m_NrOfConnections);
+		for (int idx = 0; idx < GetNrOfNodes(); ++idx)
+		{
+			const int begin{ m_Begin[idx] };
+			m_Begin[idx] = static_cast<int>(to.size());
+			m_Capacity[idx] = m_Count[idx];
+			to.insert(to.end(), m_To.begin() + begin, m_To.begin() + begin + m_Count[idx]);
+			costs.insert(costs.end(), m_Costs.begin() + begin, m_Costs.begin() + begin + m_Count[idx]);
+		}
+
+		m_To.swap(to);
+		m_Costs.swap(costs);
+		m_NrOfUnusedSlots = 0;
+	}
+
+	inline int GraphAdjacency::FindConnection(int from, int to) const
+	{
+		for (int slot = m_Begin[from]; slot < m_Begin[from] + m_Count[from]; ++slot)
+		{
+			if (m_To[slot] == to)
+				return slot;
+		}
+		return -1;
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "../EGraphEnums.h"
+#include <iterator>
+
+namespace Elite
+{
+	// Views over a graph's node storage, for range-for. They hold a couple of pointers and never allocate,
+	// they stay valid until nodes get added to the graph.
+
+	// The nodes that are part of the graph, removed ones (index invalid_node_index) are skipped
+	template <class T_NodeType>
+	class ActiveNodeView final
+	{
+	public:
+		class Iterator final
+		{
+		public:
+			Iterator(T_NodeType* const* pNode, T_NodeType* const* pEnd) : m_pNode(pNode), m_pEnd(pEnd) { SkipInactive(); }
+			T_NodeType* operator*() const { return *m_pNode; }
+			Iterator& operator++() { ++m_pNode; SkipInactive(); return *this; }
+			bool operator!=(const Iterator& other) const { return m_pNode != other.m_pNode; }
+			bool operator==(const Iterator& other) const { return m_pNode == other.m_pNode; }
+
+		private:
+			T_NodeType* const* m_pNode;
+			T_NodeType* const* m_pEnd;
+
+			void SkipInactive()
+			{
+				while (m_pNode != m_pEnd && (!*m_pNode || (*m_pNode)->GetIndex() == invalid_node_index))
+					++m_pNode;
+			}
+		};
+
+		ActiveNodeView(T_NodeType* const* pBegin, T_NodeType* const* pEnd) : m_pBegin(pBegin), m_pEnd(pEnd) {}
+		Iterator begin() const { return { m_pBegin, m_pEnd }; }
+		Iterator end() const { return { m_pEnd, m_pEnd }; }
+		bool empty() const { return !(begin() != end()); }
+
+	private:
+		T_NodeType* const* m_pBegin;
+		T_NodeType* const* m_pEnd;
+	};
+
+	// The nodes at the indices of a container of ints, in the container's order. The container has to outlive the view
+	template <class T_NodeType, class T_IndexIterator>
+	class IndexedNodeView final
+	{
+	public:
+		class Iterator final
+		{
+		public:
+			Iterator(T_NodeType* const* pNodes, T_IndexIterator indexIt) : m_pNodes(pNodes), m_IndexIt(indexIt) {}
+			T_NodeType* operator*() const { return m_pNodes[*m_IndexIt]; }
+			Iterator& operator++() { ++m_IndexIt; return *this; }
+			bool operator!=(const Iterator& other) const { return m_IndexIt != other.m_IndexIt; }
+			bool operator==(const Iterator& other) const { return m_IndexIt == other.m_IndexIt; }
+
+		private:
+			T_NodeType* const* m_pNodes;
+			T_IndexIterator m_IndexIt;
+		};
+
+		IndexedNodeView(T_NodeType* const* pNodes, T_IndexIterator first, T_IndexIterator last) : m_pNodes(pNodes), m_First(first), m_Last(last) {}
+		Iterator begin() const { return { m_pNodes, m_First }; }
+		Iterator end() const { return { m_pNodes, m_Last }; }
+		size_t size() const { return static_cast<size_t>(std::distance(m_First, m_Last)); }
+		bool empty() const { return !(m_First != m_Last); }
+
+	private:
+		T_NodeType* const* m_pNodes;
+		T_IndexIterator m_First;
+		T_IndexIterator m_Last;
+	};
+}
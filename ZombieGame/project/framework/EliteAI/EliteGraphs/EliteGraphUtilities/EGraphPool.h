@@ -0,0 +1,132 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+#include <functional>
+
+namespace Elite
+{
+	// Typed arena for the nodes and connections a graph owns. Objects are constructed back to back in chunks of contiguous
+	// memory, each chunk twice the size of the one before it (up to m_MaxChunkCapacity), and freed slots are reused before
+	// a new chunk is made. Destroying an object only runs its destructor, the memory goes back all at once in Release.
+	template <class T>
+	class GraphPool final
+	{
+	public:
+		GraphPool() = default;
+		~GraphPool() { Release(); }
+		GraphPool(const GraphPool&) = delete;
+		GraphPool& operator=(const GraphPool&) = delete;
+
+		template <typename... T_Args>
+		T* Create(T_Args&&... args);
+		void Destroy(T* pObject);
+		bool Owns(const T* pObject) const;
+
+		// Makes sure the next nrOfObjects creations land in one chunk, back to back
+		void Reserve(size_t nrOfObjects);
+		// Frees every chunk, whatever still lives in them has to be destroyed first
+		void Release();
+
+		size_t GetNrOfObjects() const { return m_NrOfObjects; }
+		size_t GetNrOfChunks() const { return m_Chunks.size(); }
+
+	private:
+		using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+		struct Chunk
+		{
+			std::unique_ptr<Storage[]> pStorage;
+			size_t capacity;
+		};
+
+		static constexpr size_t m_FirstChunkCapacity{ 256 };
+		static constexpr size_t m_MaxChunkCapacity{ 1 << 16 };
+		std::vector<Chunk> m_Chunks; // in order of creation, new objects go to the last one
+		std::vector<std::pair<const Storage*, const Storage*>> m_ChunkRanges; // begin and end of the same chunks by address, for Owns
+		size_t m_NrOfUsedInLastChunk{ 0 };
+		size_t m_NextChunkCapacity{ m_FirstChunkCapacity }; // reserved chunks don't count towards the growth
+		std::vector<T*> m_FreeSlots;
+		size_t m_NrOfObjects{ 0 };
+
+		void AddChunk(size_t capacity);
+	};
+
+	template <class T>
+	template <typename... T_Args>
+	T* GraphPool<T>::Create(T_Args&&... args)
+	{
+		// The rest of the last chunk goes first, that keeps the objects of a reserved run together
+		void* pSlot{ nullptr };
+		if (!m_Chunks.empty() && m_NrOfUsedInLastChunk < m_Chunks.back().capacity)
+		{
+			pSlot = &m_Chunks.back().pStorage[m_NrOfUsedInLastChunk++];
+		}
+		else if (!m_FreeSlots.empty())
+		{
+			pSlot = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+		}
+		else
+		{
+			AddChunk(m_NextChunkCapacity);
+			m_NextChunkCapacity = min(m_NextChunkCapacity * 2, m_MaxChunkCapacity);
+			pSlot = &m_Chunks.back().pStorage[m_NrOfUsedInLastChunk++];
+		}
+
+		T* pObject{ new (pSlot) T(std::forward<T_Args>(args)...) };
+		++m_NrOfObjects;
+		return pObject;
+	}
+
+	template <class T>
+	void GraphPool<T>::Destroy(T* pObject)
+	{
+		pObject->~T();
+		m_FreeSlots.push_back(pObject);
+		--m_NrOfObjects;
+	}
+
+	template <class T>
+	bool GraphPool<T>::Owns(const T* pObject) const
+	{
+		// the last chunk that starts at or before the object is the only one that can hold it
+		const Storage* pSlot{ reinterpret_cast<const Storage*>(pObject) };
+		const auto it = std::upper_bound(m_ChunkRanges.begin(), m_ChunkRanges.end(), pSlot,
+			[](const Storage* pSlot, const std::pair<const Storage*, const Storage*>& range) { return std::less<const Storage*>()(pSlot, range.first); });
+		return it != m_ChunkRanges.begin() && std::less<const Storage*>()(pSlot, (it - 1)->second);
+	}
+
+	template <class T>
+	void GraphPool<T>::Reserve(size_t nrOfObjects)
+	{
+		const size_t nrOfFreeInLastChunk{ m_Chunks.empty() ? 0 : m_Chunks.back().capacity - m_NrOfUsedInLastChunk };
+		if (nrOfFreeInLastChunk < nrOfObjects)
+			AddChunk(nrOfObjects);
+	}
+
+	template <class T>
+	void GraphPool<T>::Release()
+	{
+		m_Chunks.clear();
+		m_ChunkRanges.clear();
+		m_FreeSlots.clear();
+		m_NrOfUsedInLastChunk = 0;
+		m_NextChunkCapacity = m_FirstChunkCapacity;
+		m_NrOfObjects = 0;
+	}
+
+	template <class T>
+	void GraphPool<T>::AddChunk(size_t capacity)
+	{
+		// the unused tail of the previous last chunk is given up
+		Chunk chunk{};
+		chunk.pStorage.reset(new Storage[capacity]);
+		chunk.capacity = capacity;
+		const std::pair<const Storage*, const Storage*> range{ chunk.pStorage.get(), chunk.pStorage.get() + capacity };
+		m_ChunkRanges.insert(std::upper_bound(m_ChunkRanges.begin(), m_ChunkRanges.end(), range), range);
+		m_Chunks.push_back(std::move(chunk));
+		m_NrOfUsedInLastChunk = 0;
+	}
+}
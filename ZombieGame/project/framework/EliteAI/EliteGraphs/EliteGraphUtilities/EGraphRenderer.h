@@ -23,7 +23,7 @@ namespace Elite
 		void RenderGraph(GridGraph<T_NodeType, T_ConnectionType>* pGraph,IBaseInterface* pInterface, bool renderNodes, bool renderNodeTxt, bool renderConnections, bool renderConnectionsCosts) const;
 
 		template<class T_NodeType, class T_ConnectionType>
-		void RenderNodes(GridGraph<T_NodeType, T_ConnectionType>* pGraph, IBaseInterface* pInterface, std::unordered_set<int>& indices, bool renderNodes, bool renderNodeTxt, bool renderConnections, bool renderConnectionsCosts) const;
+		void RenderNodes(GridGraph<T_NodeType, T_ConnectionType>* pGraph, IBaseInterface* pInterface, const std::vector<int>& indices, bool renderNodes, bool renderNodeTxt, bool renderConnections, bool renderConnectionsCosts) const;
 
 		template<class T_NodeType, class T_ConnectionType>
 		void HighlightNodes(GridGraph<T_NodeType, T_ConnectionType>* pGraph, std::vector<T_NodeType*> path, Color col = HIGHLIGHTED_NODE_COLOR) const;
@@ -97,7 +97,7 @@ namespace Elite
 		bool renderNodeTxt /*= true*/, 
 		bool renderConnectionTxt /*= true*/) const
 	{
-		for (auto node : pGraph->GetAllNodes())
+		for (auto node : pGraph->GetActiveNodes())
 		{
 			if (renderNodes)
 			{
@@ -157,7 +157,7 @@ namespace Elite
 
 		if (renderConnections)
 		{
-			for (auto node : pGraph->GetAllNodes())
+			for (auto node : pGraph->GetActiveNodes())
 			{
 				//Connections
 				for (auto con : pGraph->GetNodeConnections(node->GetIndex()))
@@ -173,7 +173,7 @@ namespace Elite
 	}
 
 	template<class T_NodeType, class T_ConnectionType>
-	inline void GraphRenderer::RenderNodes(GridGraph<T_NodeType, T_ConnectionType>* pGraph, IBaseInterface* pInterface, std::unordered_set<int>& indices, bool renderNodes, bool renderNodeNumbers, bool renderConnections, bool renderConnectionsCosts) const
+	inline void GraphRenderer::RenderNodes(GridGraph<T_NodeType, T_ConnectionType>* pGraph, IBaseInterface* pInterface, const std::vector<int>& indices, bool renderNodes, bool renderNodeNumbers, bool renderConnections, bool renderConnectionsCosts) const
 	{
 		if (renderNodes)
 		{
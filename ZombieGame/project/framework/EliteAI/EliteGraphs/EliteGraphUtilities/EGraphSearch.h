@@ -0,0 +1,221 @@
+#pragma once
+#include "../EGraphEnums.h"
+#include <vector>
+#include <algorithm>
+
+namespace Elite
+{
+	// Bookkeeping of a search, one record per node index. Begin starts the next search by bumping a generation number
+	// instead of clearing the records, a record written by an older search reads as not visited.
+	template <class T_Record>
+	class SearchRecords final
+	{
+	public:
+		// Makes room for every node index below nrOfNodes and forgets what earlier searches wrote
+		void Begin(int nrOfNodes);
+
+		bool IsVisited(int idx) const { return m_Generations[idx] == m_Generation; }
+		// The record of idx, a default one if this search hasn't visited it yet
+		T_Record& Visit(int idx);
+		// Only for visited nodes
+		const T_Record& Get(int idx) const { return m_Records[idx]; }
+		T_Record& Get(int idx) { return m_Records[idx]; }
+
+	private:
+		std::vector<T_Record> m_Records;
+		std::vector<unsigned int> m_Generations;
+		unsigned int m_Generation{ 0 };
+	};
+
+	template <class T_Record>
+	void SearchRecords<T_Record>::Begin(int nrOfNodes)
+	{
+		if (static_cast<int>(m_Records.size()) < nrOfNodes)
+		{
+			m_Records.resize(nrOfNodes);
+			m_Generations.resize(nrOfNodes, 0);
+		}
+
+		// after 4 billion searches the numbers come round again, only then the stamps get cleared
+		if (++m_Generation == 0)
+		{
+			std::fill(m_Generations.begin(), m_Generations.end(), 0);
+			m_Generation = 1;
+		}
+	}
+
+	template <class T_Record>
+	T_Record& SearchRecords<T_Record>::Visit(int idx)
+	{
+		if (m_Generations[idx] != m_Generation)
+		{
+			m_Generations[idx] = m_Generation;
+			m_Records[idx] = T_Record{};
+		}
+		return m_Records[idx];
+	}
+
+	// Open list key of A* and the searches built on it: lowest f-cost first, on a tie the node closer to the goal.
+	// Open grids have lots of nodes with the same f-cost, going on from the one that got furthest saves expanding most of them.
+	struct EstimatedCostKey
+	{
+		float estimatedTotalCost; // f-cost (= costSoFar + heuristicCost)
+		float heuristicCost;
+
+		bool operator<(const EstimatedCostKey& other) const
+		{
+			return estimatedTotalCost < other.estimatedTotalCost
+				|| (estimatedTotalCost == other.estimatedTotalCost && heuristicCost < other.heuristicCost);
+		}
+	};
+
+	// 4-ary min heap of node indices, the open list of a search. It remembers where every node sits, so a node that is
+	// pushed again moves to its new key instead of being added twice (decrease key, or increase key).
+	// T_Key only needs operator<.
+	template <class T_Key = float>
+	class NodeHeap final
+	{
+	public:
+		// Empties the heap and makes room for every node index below nrOfNodes, costs as much as there are nodes left in it
+		void Begin(int nrOfNodes);
+
+		bool IsEmpty() const { return m_Entries.empty(); }
+		int GetSize() const { return static_cast<int>(m_Entries.size()); }
+		bool Contains(int idx) const { return m_Positions[idx] != invalid_node_index; }
+
+		// Adds idx, or moves it to key if it's already in
+		void Push(int idx, const T_Key& key);
+		void Remove(int idx);
+		int GetMin() const { return m_Entries.front().idx; }
+		const T_Key& GetMinKey() const { return m_Entries.front().key; }
+		int PopMin();
+
+	private:
+		static constexpr size_t m_Arity{ 4 };
+
+		struct Entry
+		{
+			T_Key key;
+			int idx;
+		};
+
+		std::vector<Entry> m_Entries;
+		std::vector<int> m_Positions; // per node index, its entry or invalid_node_index
+
+		void SiftUp(size_t pos);
+		void SiftDown(size_t pos);
+		void Place(size_t pos, const Entry& entry)
+		{
+			m_Entries[pos] = entry;
+			m_Positions[entry.idx] = static_cast<int>(pos);
+		}
+	};
+
+	template <class T_Key>
+	void NodeHeap<T_Key>::Begin(int nrOfNodes)
+	{
+		for (const Entry& entry : m_Entries)
+			m_Positions[entry.idx] = invalid_node_index;
+		m_Entries.clear();
+
+		if (static_cast<int>(m_Positions.size()) < nrOfNodes)
+			m_Positions.resize(nrOfNodes, invalid_node_index);
+	}
+
+	template <class T_Key>
+	void NodeHeap<T_Key>::Push(int idx, const T_Key& key)
+	{
+		const int pos{ m_Positions[idx] };
+		if (pos == invalid_node_index)
+		{
+			m_Entries.push_back({ key, idx });
+			m_Positions[idx] = static_cast<int>(m_Entries.size() - 1);
+			SiftUp(m_Entries.size() - 1);
+			return;
+		}
+
+		const bool isDecrease{ key < m_Entries[pos].key };
+		m_Entries[pos].key = key;
+		if (isDecrease)
+			SiftUp(pos);
+		else
+			SiftDown(pos);
+	}
+
+	template <class T_Key>
+	void NodeHeap<T_Key>::Remove(int idx)
+	{
+		const int pos{ m_Positions[idx] };
+		if (pos == invalid_node_index)
+			return;
+
+		m_Positions[idx] = invalid_node_index;
+		const Entry last{ m_Entries.back() };
+		m_Entries.pop_back();
+		if (pos == static_cast<int>(m_Entries.size()))
+			return;
+
+		// the last entry takes the hole, it can be out of order either way
+		Place(pos, last);
+		SiftUp(pos);
+		SiftDown(m_Positions[last.idx]);
+	}
+
+	template <class T_Key>
+	int NodeHeap<T_Key>::PopMin()
+	{
+		const int idx{ m_Entries.front().idx };
+		m_Positions[idx] = invalid_node_index;
+		const Entry last{ m_Entries.back() };
+		m_Entries.pop_back();
+		if (!m_Entries.empty())
+		{
+			Place(0, last);
+			SiftDown(0);
+		}
+		return idx;
+	}
+
+	template <class T_Key>
+	void NodeHeap<T_Key>::SiftUp(size_t pos)
+	{
+		// the entry moves up in a hole, the parents it passes shift down into it
+		const Entry entry{ m_Entries[pos] };
+		while (pos > 0)
+		{
+			const size_t parent{ (pos - 1) / m_Arity };
+			if (!(entry.key < m_Entries[parent].key))
+				break;
+			Place(pos, m_Entries[parent]);
+			pos = parent;
+		}
+		Place(pos, entry);
+	}
+
+	template <class T_Key>
+	void NodeHeap<T_Key>::SiftDown(size_t pos)
+	{
+		const Entry entry{ m_Entries[pos] };
+		const size_t size{ m_Entries.size() };
+		while (true)
+		{
+			const size_t firstChild{ pos * m_Arity + 1 };
+			if (firstChild >= size)
+				break;
+
+			size_t minChild{ firstChild };
+			const size_t lastChild{ min(firstChild + m_Arity, size) };
+			for (size_t child = firstChild + 1; child < lastChild; ++child)
+			{
+				if (m_Entries[child].key < m_Entries[minChild].key)
+					minChild = child;
+			}
+
+			if (!(m_Entries[minChild].key < entry.key))
+				break;
+			Place(pos, m_Entries[minChild]);
+			pos = minChild;
+		}
+		Place(pos, entry);
+	}
+}
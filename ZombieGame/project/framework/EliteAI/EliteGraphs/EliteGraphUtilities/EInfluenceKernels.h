@@ -0,0 +1,415 @@
+#pragma once
+#include <immintrin.h>
+#include <cmath>
+#include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Row kernels for influence propagation on a regular 8-connected grid.
+// Every cell takes the neighbour influence with the highest absolute value (after decay)
+// and blends it with its own influence using the momentum, exactly like the node based path.
+// Layers are interleaved per cell (cell0 layer0, cell0 layer1, ..., cell1 layer0, ...) so one pass propagates all of them.
+namespace Elite
+{
+	namespace InfluenceKernels
+	{
+		static constexpr int MaxLayers{ 8 };
+
+		// Decay factors and momentum per layer, repeated so a SIMD load that starts at any layer lines up with the interleaved row
+		struct LayerFactors
+		{
+			int nrOfLayers{ 1 };
+			float straight[MaxLayers * 2]{};
+			float diagonal[MaxLayers * 2]{};
+			float momentum[MaxLayers * 2]{};
+
+			void SetLayer(int layer, float straightFactor, float diagonalFactor, float layerMomentum)
+			{
+				for (int i = layer; i < MaxLayers * 2; i += nrOfLayers)
+				{
+					straight[i] = straightFactor;
+					diagonal[i] = diagonalFactor;
+					momentum[i] = layerMomentum;
+				}
+			}
+		};
+
+		// Propagates a single cell, missing neighbours (grid border) are passed as 0 which never wins the max-abs test
+		inline float PropagateCell(
+			float up, float down, float left, float right,
+			float upLeft, float upRight, float downLeft, float downRight,
+			float current, float straightFactor, float diagonalFactor, float momentum)
+		{
+			const float candidates[8]
+			{
+				left * straightFactor, right * straightFactor, up * straightFactor, down * straightFactor,
+				upLeft * diagonalFactor, upRight * diagonalFactor, downLeft * diagonalFactor, downRight * diagonalFactor
+			};
+
+			float highestInfluence{ 0 };
+			for (float candidate : candidates)
+			{
+				if (std::abs(candidate) > std::abs(highestInfluence))
+					highestInfluence = candidate;
+			}
+
+			return (1 - momentum) * highestInfluence + momentum * current;
+		}
+
+		// Propagates the interleaved values [begin, end) of a row, bounds checked so it can be used on the first and last column
+		inline void PropagateValuesScalar(const float* pUp, const float* pMid, const float* pDown, float* pOut,
+			int columns, int begin, int end, const LayerFactors& factors)
+		{
+			const int stride{ factors.nrOfLayers };
+			for (int i = begin; i < end; ++i)
+			{
+				const int c{ i / stride };
+				const int layer{ i % stride };
+				const bool hasLeft{ c > 0 };
+				const bool hasRight{ c < columns - 1 };
+
+				pOut[i] = PropagateCell(
+					pUp[i], pDown[i],
+					hasLeft ? pMid[i - stride] : 0.f, hasRight ? pMid[i + stride] : 0.f,
+					hasLeft ? pUp[i - stride] : 0.f, hasRight ? pUp[i + stride] : 0.f,
+					hasLeft ? pDown[i - stride] : 0.f, hasRight ? pDown[i + stride] : 0.f,
+					pMid[i], factors.straight[layer], factors.diagonal[layer], factors.momentum[layer]);
+			}
+		}
+
+		// Propagates columns [begin, end) of a row, all layers
+		inline void PropagateRowScalar(const float* pUp, const float* pMid, const float* pDown, float* pOut,
+			int columns, int begin, int end, const LayerFactors& factors)
+		{
+			PropagateValuesScalar(pUp, pMid, pDown, pOut, columns, begin * factors.nrOfLayers, end * factors.nrOfLayers, factors);
+		}
+
+#if defined(__AVX2__)
+		inline __m256 SelectMaxAbs8(__m256 best, __m256 candidate, __m256 signMask)
+		{
+			const __m256 isHigher{ _mm256_cmp_ps(_mm256_andnot_ps(signMask, candidate), _mm256_andnot_ps(signMask, best), _CMP_GT_OQ) };
+			return _mm256_blendv_ps(best, candidate, isHigher);
+		}
+#endif
+
+		inline __m128 SelectMaxAbs4(__m128 best, __m128 candidate, __m128 signMask)
+		{
+			// SSE2 only, so no blendv
+			const __m128 isHigher{ _mm_cmpgt_ps(_mm_andnot_ps(signMask, candidate), _mm_andnot_ps(signMask, best)) };
+			return _mm_or_ps(_mm_and_ps(isHigher, candidate), _mm_andnot_ps(isHigher, best));
+		}
+
+		// Propagates columns [begin, end) of a row, all layers. pUp/pDown point to a row of zeroes at the top/bottom border.
+		// Interior values run 8 (AVX2) or 4 (SSE2) at a time, the border columns and the tail run scalar.
+		inline void PropagateRow(const float* pUp, const float* pMid, const float* pDown, float* pOut,
+			int columns, int begin, int end, const LayerFactors& factors)
+		{
+			const int stride{ factors.nrOfLayers };
+			int i{ (begin > 1 ? begin : 1) * stride };
+			const int last{ (end < columns - 1 ? end : columns - 1) * stride };
+			if (i >= last)
+			{
+				PropagateRowScalar(pUp, pMid, pDown, pOut, columns, begin, end, factors);
+				return;
+			}
+
+			PropagateValuesScalar(pUp, pMid, pDown, pOut, columns, begin * stride, i, factors);
+
+#if defined(__AVX2__)
+			{
+				const __m256 signMask{ _mm256_set1_ps(-0.f) };
+				const __m256 one{ _mm256_set1_ps(1.f) };
+				for (; i + 8 <= last; i += 8)
+				{
+					const int layer{ i % stride };
+					const __m256 straight{ _mm256_loadu_ps(factors.straight + layer) };
+					const __m256 diagonal{ _mm256_loadu_ps(factors.diagonal + layer) };
+					const __m256 keep{ _mm256_loadu_ps(factors.momentum + layer) };
+
+					__m256 best{ _mm256_setzero_ps() };
+					best = SelectMaxAbs8(best, _mm256_mul_ps(_mm256_loadu_ps(pMid + i - stride), straight), signMask);
+					best = SelectMaxAbs8(best, _mm256_mul_ps(_mm256_loadu_ps(pMid + i + stride), straight), signMask);
+					best = SelectMaxAbs8(best, _mm256_mul_ps(_mm256_loadu_ps(pUp + i), straight), signMask);
+					best = SelectMaxAbs8(best, _mm256_mul_ps(_mm256_loadu_ps(pDown + i), straight), signMask);
+					best = SelectMaxAbs8(best, _mm256_mul_ps(_mm256_loadu_ps(pUp + i - stride), diagonal), signMask);
+					best = SelectMaxAbs8(best, _mm256_mul_ps(_mm256_loadu_ps(pUp + i + stride), diagonal), signMask);
+					best = SelectMaxAbs8(best, _mm256_mul_ps(_mm256_loadu_ps(pDown + i - stride), diagonal), signMask);
+					best = SelectMaxAbs8(best, _mm256_mul_ps(_mm256_loadu_ps(pDown + i + stride), diagonal), signMask);
+
+					const __m256 current{ _mm256_loadu_ps(pMid + i) };
+					_mm256_storeu_ps(pOut + i, _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(one, keep), best), _mm256_mul_ps(keep, current)));
+				}
+			}
+#endif
+			{
+				const __m128 signMask{ _mm_set1_ps(-0.f) };
+				const __m128 one{ _mm_set1_ps(1.f) };
+				for (; i + 4 <= last; i += 4)
+				{
+					const int layer{ i % stride };
+					const __m128 straight{ _mm_loadu_ps(factors.straight + layer) };
+					const __m128 diagonal{ _mm_loadu_ps(factors.diagonal + layer) };
+					const __m128 keep{ _mm_loadu_ps(factors.momentum + layer) };
+
+					__m128 best{ _mm_setzero_ps() };
+					best = SelectMaxAbs4(best, _mm_mul_ps(_mm_loadu_ps(pMid + i - stride), straight), signMask);
+					best = SelectMaxAbs4(best, _mm_mul_ps(_mm_loadu_ps(pMid + i + stride), straight), signMask);
+					best = SelectMaxAbs4(best, _mm_mul_ps(_mm_loadu_ps(pUp + i), straight), signMask);
+					best = SelectMaxAbs4(best, _mm_mul_ps(_mm_loadu_ps(pDown + i), straight), signMask);
+					best = SelectMaxAbs4(best, _mm_mul_ps(_mm_loadu_ps(pUp + i - stride), diagonal), signMask);
+					best = SelectMaxAbs4(best, _mm_mul_ps(_mm_loadu_ps(pUp + i + stride), diagonal), signMask);
+					best = SelectMaxAbs4(best, _mm_mul_ps(_mm_loadu_ps(pDown + i - stride), diagonal), signMask);
+					best = SelectMaxAbs4(best, _mm_mul_ps(_mm_loadu_ps(pDown + i + stride), diagonal), signMask);
+
+					const __m128 current{ _mm_loadu_ps(pMid + i) };
+					_mm_storeu_ps(pOut + i, _mm_add_ps(_mm_mul_ps(_mm_sub_ps(one, keep), best), _mm_mul_ps(keep, current)));
+				}
+			}
+
+			PropagateValuesScalar(pUp, pMid, pDown, pOut, columns, i, end * stride, factors);
+		}
+
+		// Fixed point variant: influence in Q8.8 (int16_t), factors in Q15 so a multiply is one _mm_mulhrs_epi16.
+		// Values are kept in [-32767, 32767] so the absolute value never overflows.
+		static constexpr int FixedMax{ 32767 };
+
+		inline int16_t ToFixedFactor(float factor)
+		{
+			const float scaled{ factor * 32768.f + 0.5f };
+			return static_cast<int16_t>(scaled < 0 ? 0 : (scaled > FixedMax ? FixedMax : scaled));
+		}
+
+		// Factors per layer in Q15, the decay of the straight and diagonal neighbours is worked out once per sweep.
+		// 16 lanes (AVX2) starting at any layer have to fit, hence the extra repeat.
+		struct FixedLayerFactors
+		{
+			int nrOfLayers{ 1 };
+			int16_t straight[MaxLayers * 3]{};
+			int16_t diagonal[MaxLayers * 3]{};
+			int16_t keep[MaxLayers * 3]{};
+			int16_t release[MaxLayers * 3]{};
+
+			void SetLayer(int layer, float straightFactor, float diagonalFactor, float layerMomentum)
+			{
+				for (int i = layer; i < MaxLayers * 3; i += nrOfLayers)
+				{
+					straight[i] = ToFixedFactor(straightFactor);
+					diagonal[i] = ToFixedFactor(diagonalFactor);
+					keep[i] = ToFixedFactor(layerMomentum);
+					release[i] = ToFixedFactor(1 - layerMomentum);
+				}
+			}
+		};
+
+		// Rounds exactly like _mm_mulhrs_epi16 so the scalar border and the SIMD interior agree
+		inline int MulFixed(int value, int factor)
+		{
+			return (value * factor + 0x4000) >> 15;
+		}
+
+		inline int16_t PropagateCellFixed(
+			int up, int down, int left, int right,
+			int upLeft, int upRight, int downLeft, int downRight,
+			int current, int straightFactor, int diagonalFactor, int keep, int release)
+		{
+			const int candidates[8]
+			{
+				MulFixed(left, straightFactor), MulFixed(right, straightFactor), MulFixed(up, straightFactor), MulFixed(down, straightFactor),
+				MulFixed(upLeft, diagonalFactor), MulFixed(upRight, diagonalFactor), MulFixed(downLeft, diagonalFactor), MulFixed(downRight, diagonalFactor)
+			};
+
+			int highestInfluence{ 0 };
+			for (int candidate : candidates)
+			{
+				if (std::abs(candidate) > std::abs(highestInfluence))
+					highestInfluence = candidate;
+			}
+
+			const int result{ MulFixed(highestInfluence, release) + MulFixed(current, keep) };
+			return static_cast<int16_t>(result < -FixedMax ? -FixedMax : (result > FixedMax ? FixedMax : result));
+		}
+
+		inline void PropagateValuesScalar(const int16_t* pUp, const int16_t* pMid, const int16_t* pDown, int16_t* pOut,
+			int columns, int begin, int end, const FixedLayerFactors& factors)
+		{
+			const int stride{ factors.nrOfLayers };
+			for (int i = begin; i < end; ++i)
+			{
+				const int c{ i / stride };
+				const int layer{ i % stride };
+				const bool hasLeft{ c > 0 };
+				const bool hasRight{ c < columns - 1 };
+
+				pOut[i] = PropagateCellFixed(
+					pUp[i], pDown[i],
+					hasLeft ? pMid[i - stride] : 0, hasRight ? pMid[i + stride] : 0,
+					hasLeft ? pUp[i - stride] : 0, hasRight ? pUp[i + stride] : 0,
+					hasLeft ? pDown[i - stride] : 0, hasRight ? pDown[i + stride] : 0,
+					pMid[i], factors.straight[layer], factors.diagonal[layer], factors.keep[layer], factors.release[layer]);
+			}
+		}
+
+#if defined(__AVX2__)
+		inline __m256i SelectMaxAbs16(__m256i best, __m256i candidate)
+		{
+			const __m256i isHigher{ _mm256_cmpgt_epi16(_mm256_abs_epi16(candidate), _mm256_abs_epi16(best)) };
+			return _mm256_blendv_epi8(best, candidate, isHigher);
+		}
+#endif
+
+		// MSVC has no SSSE3 macro and compiles the intrinsics for any target, /arch:AVX and up is the first switch that guarantees them.
+		// Below that the 8-wide loop builds mulhrs and abs from SSE2, which every x64 target has, with the same results
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		inline __m128i MulHrs8(__m128i a, __m128i b)
+		{
+#if defined(__SSSE3__) || defined(__AVX__)
+			return _mm_mulhrs_epi16(a, b);
+#else
+			// ((p >> 14) + 1) >> 1 of the 32 bit product p is (p >> 15) + bit 14 of p
+			const __m128i high{ _mm_mulhi_epi16(a, b) };
+			const __m128i low{ _mm_mullo_epi16(a, b) };
+			const __m128i truncated{ _mm_or_si128(_mm_slli_epi16(high, 1), _mm_srli_epi16(low, 15)) };
+			return _mm_add_epi16(truncated, _mm_and_si128(_mm_srli_epi16(low, 14), _mm_set1_epi16(1)));
+#endif
+		}
+
+		inline __m128i Abs8(__m128i value)
+		{
+#if defined(__SSSE3__) || defined(__AVX__)
+			return _mm_abs_epi16(value);
+#else
+			return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(), value));
+#endif
+		}
+
+		inline __m128i SelectMaxAbs8(__m128i best, __m128i candidate)
+		{
+			const __m128i isHigher{ _mm_cmpgt_epi16(Abs8(candidate), Abs8(best)) };
+			return _mm_or_si128(_mm_and_si128(isHigher, candidate), _mm_andnot_si128(isHigher, best));
+		}
+#endif
+
+		// Same contract as the float PropagateRow. Interior values run 16 (AVX2) or 8 (SSE) at a time,
+		// half the bytes per value means twice the cells per load.
+		inline void PropagateRow(const int16_t* pUp, const int16_t* pMid, const int16_t* pDown, int16_t* pOut,
+			int columns, int begin, int end, const FixedLayerFactors& factors)
+		{
+			const int stride{ factors.nrOfLayers };
+			int i{ (begin > 1 ? begin : 1) * stride };
+			const int last{ (end < columns - 1 ? end : columns - 1) * stride };
+			if (i >= last)
+			{
+				PropagateValuesScalar(pUp, pMid, pDown, pOut, columns, begin * stride, end * stride, factors);
+				return;
+			}
+
+			PropagateValuesScalar(pUp, pMid, pDown, pOut, columns, begin * stride, i, factors);
+
+#if defined(__AVX2__)
+			{
+				const __m256i lowest{ _mm256_set1_epi16(-FixedMax) };
+				for (; i + 16 <= last; i += 16)
+				{
+					const int layer{ i % stride };
+					const __m256i straight{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(factors.straight + layer)) };
+					const __m256i diagonal{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(factors.diagonal + layer)) };
+					const __m256i keep{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(factors.keep + layer)) };
+					const __m256i release{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(factors.release + layer)) };
+
+					const auto load = [](const int16_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); };
+
+					__m256i best{ _mm256_setzero_si256() };
+					best = SelectMaxAbs16(best, _mm256_mulhrs_epi16(load(pMid + i - stride), straight));
+					best = SelectMaxAbs16(best, _mm256_mulhrs_epi16(load(pMid + i + stride), straight));
+					best = SelectMaxAbs16(best, _mm256_mulhrs_epi16(load(pUp + i), straight));
+					best = SelectMaxAbs16(best, _mm256_mulhrs_epi16(load(pDown + i), straight));
+					best = SelectMaxAbs16(best, _mm256_mulhrs_epi16(load(pUp + i - stride), diagonal));
+					best = SelectMaxAbs16(best, _mm256_mulhrs_epi16(load(pUp + i + stride), diagonal));
+					best = SelectMaxAbs16(best, _mm256_mulhrs_epi16(load(pDown + i - stride), diagonal));
+					best = SelectMaxAbs16(best, _mm256_mulhrs_epi16(load(pDown + i + stride), diagonal));
+
+					const __m256i blended{ _mm256_adds_epi16(_mm256_mulhrs_epi16(best, release), _mm256_mulhrs_epi16(load(pMid + i), keep)) };
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(pOut + i), _mm256_max_epi16(blended, lowest));
+				}
+			}
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+			{
+				const __m128i lowest{ _mm_set1_epi16(-FixedMax) };
+				for (; i + 8 <= last; i += 8)
+				{
+					const int layer{ i % stride };
+					const __m128i straight{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(factors.straight + layer)) };
+					const __m128i diagonal{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(factors.diagonal + layer)) };
+					const __m128i keep{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(factors.keep + layer)) };
+					const __m128i release{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(factors.release + layer)) };
+
+					const auto load = [](const int16_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); };
+
+					__m128i best{ _mm_setzero_si128() };
+					best = SelectMaxAbs8(best, MulHrs8(load(pMid + i - stride), straight));
+					best = SelectMaxAbs8(best, MulHrs8(load(pMid + i + stride), straight));
+					best = SelectMaxAbs8(best, MulHrs8(load(pUp + i), straight));
+					best = SelectMaxAbs8(best, MulHrs8(load(pDown + i), straight));
+					best = SelectMaxAbs8(best, MulHrs8(load(pUp + i - stride), diagonal));
+					best = SelectMaxAbs8(best, MulHrs8(load(pUp + i + stride), diagonal));
+					best = SelectMaxAbs8(best, MulHrs8(load(pDown + i - stride), diagonal));
+					best = SelectMaxAbs8(best, MulHrs8(load(pDown + i + stride), diagonal));
+
+					const __m128i blended{ _mm_adds_epi16(MulHrs8(best, release), MulHrs8(load(pMid + i), keep)) };
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(pOut + i), _mm_max_epi16(blended, lowest));
+				}
+			}
+#endif
+
+			PropagateValuesScalar(pUp, pMid, pDown, pOut, columns, i, end * stride, factors);
+		}
+
+		// Number of set bits in a word of the scanned bitmap
+		inline int CountBits(uint64_t word)
+		{
+			// __popcnt is emitted as POPCNT whatever the target, only /arch:AVX and up guarantees the CPU has it
+#if defined(_MSC_VER) && defined(__AVX__) && defined(_M_X64)
+			return static_cast<int>(__popcnt64(word));
+#elif defined(_MSC_VER) && defined(__AVX__)
+			return static_cast<int>(__popcnt(static_cast<unsigned int>(word)) + __popcnt(static_cast<unsigned int>(word >> 32)));
+#elif defined(_MSC_VER)
+			word -= (word >> 1) & 0x5555555555555555ull;
+			word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+			word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0full;
+			return static_cast<int>((word * 0x0101010101010101ull) >> 56);
+#else
+			return __builtin_popcountll(word);
+#endif
+		}
+	}
+
+	// Storage policies of InfluenceMap: the type a cell stores its influence in and the row kernel that propagates it.
+	// Everything outside the sweep reads and writes influence as float through ToFloat/FromFloat.
+	struct FloatInfluence
+	{
+		using Value = float;
+		using Factors = InfluenceKernels::LayerFactors;
+
+		static float ToFloat(Value value) { return value; }
+		static Value FromFloat(float influence) { return influence; }
+	};
+
+	// Q8.8 fixed point: half the memory and bandwidth of float, influence saturates at about +-128 in steps of 1/256
+	struct FixedPointInfluence
+	{
+		using Value = int16_t;
+		using Factors = InfluenceKernels::FixedLayerFactors;
+
+		static constexpr float Scale{ 256.f };
+
+		static float ToFloat(Value value) { return value / Scale; }
+		static Value FromFloat(float influence)
+		{
+			const float scaled{ std::round(influence * Scale) };
+			const float limit{ static_cast<float>(InfluenceKernels::FixedMax) };
+			return static_cast<Value>(scaled < -limit ? -limit : (scaled > limit ? limit : scaled));
+		}
+	};
+}
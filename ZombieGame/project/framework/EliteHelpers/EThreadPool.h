@@ -0,0 +1,185 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace Elite
+{
+	// Small work-stealing pool for data parallel loops (see ParallelFor).
+	// Every worker, and the calling thread, owns a queue of index ranges: it pops from the back of its own queue
+	// and steals from the front of the others once it runs dry, so uneven chunks still keep every core busy.
+	class ThreadPool final
+	{
+	public:
+		explicit ThreadPool(unsigned int nrOfWorkers) { Start(nrOfWorkers); }
+		~ThreadPool() { Stop(); }
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		unsigned int GetNrOfWorkers() const { return static_cast<unsigned int>(m_Workers.size()); }
+
+		// Calls function(begin, end) for chunks of grainSize indices covering [0, count).
+		// Blocks until every chunk ran, the calling thread works along. Only one loop can run at a time.
+		void ParallelFor(int count, int grainSize, const std::function<void(int, int)>& function);
+
+	private:
+		using Chunk = std::pair<int, int>;
+		struct WorkQueue
+		{
+			std::mutex mutex;
+			std::deque<Chunk> chunks;
+		};
+
+		std::vector<std::thread> m_Workers;
+		std::vector<std::unique_ptr<WorkQueue>> m_Queues; // one per worker, the last one belongs to the calling thread
+
+		const std::function<void(int, int)>* m_pFunction{ nullptr };
+		std::atomic<int> m_RemainingChunks{ 0 };
+
+		std::mutex m_WakeMutex;
+		std::condition_variable m_WakeCondition;
+		size_t m_Generation{ 0 };
+		bool m_IsStopping{ false };
+
+		std::mutex m_DoneMutex;
+		std::condition_variable m_DoneCondition;
+
+		void Start(unsigned int nrOfWorkers);
+		void Stop();
+		void WorkerLoop(size_t queueIdx);
+		void RunChunks(size_t queueIdx);
+		bool TryPopChunk(size_t queueIdx, Chunk& chunk);
+	};
+
+	inline void ThreadPool::Start(unsigned int nrOfWorkers)
+	{
+		for (unsigned int i = 0; i <= nrOfWorkers; ++i)
+			m_Queues.push_back(std::make_unique<WorkQueue>());
+
+		for (unsigned int i = 0; i < nrOfWorkers; ++i)
+			m_Workers.emplace_back(&ThreadPool::WorkerLoop, this, static_cast<size_t>(i));
+	}
+
+	inline void ThreadPool::Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ m_WakeMutex };
+			m_IsStopping = true;
+		}
+		m_WakeCondition.notify_all();
+
+		for (auto& worker : m_Workers)
+			worker.join();
+	}
+
+	inline void ThreadPool::ParallelFor(int count, int grainSize, const std::function<void(int, int)>& function)
+	{
+		if (count <= 0)
+			return;
+
+		if (grainSize < 1)
+			grainSize = 1;
+
+		const int nrOfChunks{ (count + grainSize - 1) / grainSize };
+		if (m_Workers.empty() || nrOfChunks == 1)
+		{
+			function(0, count);
+			return;
+		}
+
+		m_pFunction = &function;
+		m_RemainingChunks = nrOfChunks;
+
+		//deal the chunks out round robin so every thread starts on its own part of the range
+		for (int i = 0; i < nrOfChunks; ++i)
+		{
+			const int begin{ i * grainSize };
+			const int end{ begin + grainSize < count ? begin + grainSize : count };
+
+			WorkQueue& queue{ *m_Queues[i % m_Queues.size()] };
+			std::lock_guard<std::mutex> lock{ queue.mutex };
+			queue.chunks.emplace_back(begin, end);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock{ m_WakeMutex };
+			++m_Generation;
+		}
+		m_WakeCondition.notify_all();
+
+		RunChunks(m_Queues.size() - 1);
+
+		std::unique_lock<std::mutex> lock{ m_DoneMutex };
+		m_DoneCondition.wait(lock, [this]() { return m_RemainingChunks == 0; });
+		m_pFunction = nullptr;
+	}
+
+	inline void ThreadPool::WorkerLoop(size_t queueIdx)
+	{
+		size_t seenGeneration{ 0 };
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock{ m_WakeMutex };
+				m_WakeCondition.wait(lock, [&]() { return m_IsStopping || m_Generation != seenGeneration; });
+				if (m_IsStopping)
+					return;
+
+				seenGeneration = m_Generation;
+			}
+
+			RunChunks(queueIdx);
+		}
+	}
+
+	inline void ThreadPool::RunChunks(size_t queueIdx)
+	{
+		Chunk chunk{};
+		while (TryPopChunk(queueIdx, chunk))
+		{
+			(*m_pFunction)(chunk.first, chunk.second);
+
+			if (--m_RemainingChunks == 0)
+			{
+				std::lock_guard<std::mutex> lock{ m_DoneMutex };
+				m_DoneCondition.notify_all();
+			}
+		}
+	}
+
+	inline bool ThreadPool::TryPopChunk(size_t queueIdx, Chunk& chunk)
+	{
+		//own queue first, newest chunk
+		{
+			WorkQueue& queue{ *m_Queues[queueIdx] };
+			std::lock_guard<std::mutex> lock{ queue.mutex };
+			if (!queue.chunks.empty())
+			{
+				chunk = queue.chunks.back();
+				queue.chunks.pop_back();
+				return true;
+			}
+		}
+
+		//then steal the oldest chunk of another thread
+		for (size_t offset = 1; offset < m_Queues.size(); ++offset)
+		{
+			WorkQueue& queue{ *m_Queues[(queueIdx + offset) % m_Queues.size()] };
+			std::lock_guard<std::mutex> lock{ queue.mutex };
+			if (!queue.chunks.empty())
+			{
+				chunk = queue.chunks.front();
+				queue.chunks.pop_front();
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
@@ -105,16 +105,11 @@ SteeringPlugin_Output ClearArea::CalculateSteering(float deltaT, const IExamInte
 
 	if (m_ReachedTarget)
 	{
-		for (auto it = m_AreaToClear.begin(); it != m_AreaToClear.end(); ) {
-			const auto& node{ m_pInfluenceMap->GetNode(*it) };
-			if (node->GetScanned())
-				it = m_AreaToClear.erase(it);
-			else
-				++it;
-		}
-		
-		if(!m_AreaToClear.empty())
-			m_Target.Position = m_pInfluenceMap->GetNode(*m_AreaToClear.begin())->GetPosition();
+		// Head for the nearest unscanned cell of the area, the distance transform of the scanned bitmap (masked with the
+		// area, see SetArea) has it without going over the area
+		const int targetIdx{ m_pInfluenceMap->GetNearestUnscannedCell(agentInfo.Location) };
+		if (targetIdx != Elite::invalid_node_index)
+			m_Target.Position = m_pInfluenceMap->GetNode(targetIdx)->GetPosition();
 	}
 
 	int arriveRange{ m_pInfluenceMap->GetCellSize() };
@@ -130,6 +125,81 @@ SteeringPlugin_Output ClearArea::CalculateSteering(float deltaT, const IExamInte
 }
 
 
+void FollowPath::Initialize(std::shared_ptr<SurvivorAgentMemory> pMemory)
+{
+	InfluenceNavigation::Initialize(pMemory);
+
+	// Same cost as FindSafePath, but on the danger the change list last reported, so the planner's costs never drift from
+	// what it was told. The influence grid keeps the default connection costs
+	m_pPlanner = std::make_unique<Elite::DStarLite<Elite::WorldNode, Elite::GraphConnection>>(m_pInfluenceMap, Elite::HeuristicFunctions::GridOctile,
+		[this](int toIdx, float connectionCost) { return connectionCost * (1.f + m_DangerPenalty * max(-m_pInfluenceMap->GetWatchedInfluence(toIdx), 0.f)); });
+	m_pOpenGroundPlanner = std::make_unique<Elite::JumpPointSearch<Elite::WorldNode, Elite::GraphConnection>>(m_pInfluenceMap, Elite::HeuristicFunctions::GridOctile);
+}
+
+bool FollowPath::FindOpenGroundPath(int startIdx, int goalIdx)
+{
+	// The octile path stays inside the box the two cells span, with no danger in there it's also the cheapest one with
+	// the danger penalty. The box reaches half a cell past both cell centres
+	const Elite::Vector2 goal{ m_pInfluenceMap->GetNodeWorldPos(goalIdx) };
+	const Elite::Vector2 from{ m_pInfluenceMap->GetNodeWorldPos(startIdx) };
+	const float cellSize{ static_cast<float>(m_pInfluenceMap->GetCellSize()) };
+	const Elite::Vector2 size{ abs(goal.x - from.x) + cellSize, abs(goal.y - from.y) + cellSize };
+	if (m_pInfluenceMap->GetMinInfluenceInRect((from + goal) / 2.f, size, InfluenceLayer::DANGER) < m_OpenGroundDanger)
+		return false;
+
+	m_OpenGroundPath = m_pOpenGroundPlanner->FindPath(m_pInfluenceMap->GetNode(startIdx), m_pInfluenceMap->GetNode(goalIdx));
+	m_PathCells.clear();
+	for (const Elite::WorldNode* pNode : m_OpenGroundPath)
+		m_PathCells.push_back(pNode->GetIndex());
+	return !m_PathCells.empty();
+}
+
+SteeringPlugin_Output FollowPath::CalculateSteering(float deltaT, const IExamInterface* pInterface)
+{
+	const AgentInfo& agentInfo{ pInterface->Agent_GetInfo() };
+
+	m_TimeSinceReplan += deltaT;
+	if (m_NeedsReplan || m_TimeSinceReplan >= m_ReplanInterval)
+	{
+		// Only the cells whose danger moved get repaired, a plan to the same destination costs a fraction of a new search.
+		// The changes go to the repairing planner on open ground too, it picks up from there once danger shows up.
+		// Without a path (outside the map) the destination is sought directly
+		m_pInfluenceMap->TakeChangedCells(m_ChangedCells);
+		m_pPlanner->OnCellsChanged(m_ChangedCells);
+		const int startIdx{ m_pInfluenceMap->GetNodeIdxAtWorldPos(agentInfo.Location) };
+		const int goalIdx{ m_pInfluenceMap->GetNodeIdxAtWorldPos(m_Destination) };
+		const bool isInMap{ startIdx != invalid_node_index && goalIdx != invalid_node_index };
+		if ((isInMap && FindOpenGroundPath(startIdx, goalIdx)) || m_pPlanner->FindPath(startIdx, goalIdx, m_PathCells))
+		{
+			m_pInfluenceMap->GetPathWaypoints(agentInfo.Location, m_PathCells, InfluenceLayer::DANGER, m_Waypoints);
+			m_Waypoints.back() = m_Destination;
+		}
+		else
+		{
+			m_Waypoints.clear();
+		}
+		m_WaypointIdx = 0;
+		m_TimeSinceReplan = 0.f;
+		m_NeedsReplan = false;
+	}
+
+	// Move on to the next waypoint once within a cell of the current one, the last one is only left by a new plan
+	const float arriveRange{ static_cast<float>(m_pInfluenceMap->GetCellSize()) };
+	while (m_WaypointIdx + 1 < m_Waypoints.size() && m_Waypoints[m_WaypointIdx].DistanceSquared(agentInfo.Location) < arriveRange * arriveRange)
+		++m_WaypointIdx;
+
+	SetTarget(m_Waypoints.empty() ? m_Destination : m_Waypoints[m_WaypointIdx]);
+	return Seek::CalculateSteering(deltaT, pInterface);
+}
+
+void FollowPath::SetDestination(const Elite::Vector2& destination)
+{
+	if (m_pInfluenceMap->GetNodeIdxAtWorldPos(destination) != m_pInfluenceMap->GetNodeIdxAtWorldPos(m_Destination))
+		m_NeedsReplan = true;
+
+	m_Destination = destination;
+}
+
 SteeringPlugin_Output NavigateInfluence::CalculateSteering(float deltaT, const IExamInterface* pInterface)
 {
 	std::cout << "Navigating Influence\n";
@@ -139,27 +209,33 @@ SteeringPlugin_Output NavigateInfluence::CalculateSteering(float deltaT, const I
 
 
 	const float influenceWeight = 1.f; // This variable can be adjusted to increase or decrease the weight of influence
-	// Get nodes in fov range
-	const auto& nodeIndices{ m_pInfluenceMap->GetNodeIndicesInRadius(agentInfo.Location, agentInfo.FOV_Range * 4) };
-	const auto& nodes{ m_pInfluenceMap->GetNodes(nodeIndices) };
-
-	for (const auto& node : nodes)
+	// Go over the nodes in fov range that hold danger, cells without influence don't add anything
+	m_pInfluenceMap->ForEachInfluenceInRadius(agentInfo.Location, agentInfo.FOV_Range * 4, InfluenceLayer::DANGER, [&](int nodeIdx, float influence)
 	{
-		Elite::Vector2 nodePos{ node->GetPosition() };
+		Elite::Vector2 nodePos{ m_pInfluenceMap->GetNodeWorldPos(nodeIdx) };
 		Elite::Vector2 toNodeVec = nodePos - agentInfo.Location;
 		float distSq = toNodeVec.MagnitudeSquared();
 		toNodeVec.Normalize();
-		float influence = node->GetInfluence();
 
 		// Subtract low influence and add high influence
 		steering.LinearVelocity -= toNodeVec * influenceWeight * influence * (1.f - distSq / (agentInfo.FOV_Range * agentInfo.FOV_Range));
-	}
+	});
+
+	// Keep off the cells walked lately (the exploration layer fades behind the agent), running back and forth over the same
+	// ground leads back to what it ran from. The walked cells hold negative influence, adding it pushes away from them
+	const float explorationWeight{ .2f };
+	m_pInfluenceMap->ForEachInfluenceInRadius(agentInfo.Location, agentInfo.FOV_Range, InfluenceLayer::EXPLORATION, [&](int nodeIdx, float influence)
+	{
+		const Elite::Vector2 toNodeVec{ m_pInfluenceMap->GetNodeWorldPos(nodeIdx) - agentInfo.Location };
+		const float falloff{ 1.f - toNodeVec.MagnitudeSquared() / (agentInfo.FOV_Range * agentInfo.FOV_Range) };
+		steering.LinearVelocity += toNodeVec.GetNormalized() * explorationWeight * influence * max(falloff, 0.f);
+	});
 
 	steering.LinearVelocity.Normalize();
 	steering.LinearVelocity *= agentInfo.MaxLinearSpeed;
 
 	// Normalize the vector
-	const bool isDangerous{ m_pInfluenceMap->GetNodeAtWorldPos(agentInfo.Location)->GetInfluence() < -10.0f };
+	const bool isDangerous{ m_pInfluenceMap->GetInfluenceAtPosition(agentInfo.Location, InfluenceLayer::DANGER) < -10.0f };
 	steering.RunMode = isDangerous;
 
 	steering.AngularVelocity = agentInfo.MaxAngularSpeed;
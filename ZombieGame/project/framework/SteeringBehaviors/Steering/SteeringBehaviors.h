@@ -15,6 +15,8 @@
 #include "..\..\EliteAI\EliteGraphs\EGraph2D.h"
 #include "..\..\EliteAI\EliteGraphs\EGridGraph.h"
 #include "..\..\EliteAI\EliteGraphs\EInfluenceMap.h"
+#include "..\..\EliteAI\EliteGraphs\EliteGraphAlgorithms\EDStarLite.h"
+#include "..\..\EliteAI\EliteGraphs\EliteGraphAlgorithms\EJumpPointSearch.h"
 #include "..\..\..\SurvivorAgentMemory.h"
 
 class SteeringAgent;
@@ -118,10 +120,11 @@ public:
 	virtual ~ClearArea() = default;
 
 	SteeringPlugin_Output CalculateSteering(float deltaT, const IExamInterface* pInterface) override;
-	void SetArea(std::unordered_set<int> area) { m_AreaToClear = area; };
-	void AddToArea(std::unordered_set<int> toAdd) { m_AreaToClear.insert(toAdd.begin(), toAdd.end()); };
-	std::unordered_set<int> GetArea() { return m_AreaToClear; };
-	bool IsExplored() const { return m_AreaToClear.empty(); };
+	// The area becomes the target of the influence map's unscanned queries, the scanned cells of it are left in
+	void SetArea(const std::unordered_set<int>& area) { m_AreaToClear = area; m_pInfluenceMap->SetScanTargetArea(m_AreaToClear); };
+	void AddToArea(const std::unordered_set<int>& toAdd) { m_AreaToClear.insert(toAdd.begin(), toAdd.end()); m_pInfluenceMap->SetScanTargetArea(m_AreaToClear); };
+	const std::unordered_set<int>& GetArea() const { return m_AreaToClear; };
+	bool IsExplored() const { return m_AreaToClear.empty() || m_pInfluenceMap->IsScanTargetAreaScanned(); };
 	void SetReachedTarget(bool reached) { m_ReachedTarget = reached; };
 protected:
 	std::unordered_set<int> m_AreaToClear{};
@@ -147,6 +150,45 @@ protected:
 	float m_ExtensionLength{ 10.f };
 };
 
+///////////////////////////////////////
+//FOLLOW PATH
+//****
+// Seeks along a path around the danger in the influence map. The path is planned again when the destination moves to
+// another cell and every m_ReplanInterval, the danger moves with the zombies. Without a path it seeks the destination directly.
+class FollowPath final : public InfluenceNavigation
+{
+public:
+	FollowPath() = default;
+	virtual ~FollowPath() = default;
+
+	void Initialize(std::shared_ptr<SurvivorAgentMemory> pMemory);
+	SteeringPlugin_Output CalculateSteering(float deltaT, const IExamInterface* pInterface) override;
+	void SetDestination(const Elite::Vector2& destination);
+	void Replan() { m_NeedsReplan = true; };
+	const std::vector<Elite::Vector2>& GetWaypoints() const { return m_Waypoints; };
+
+protected:
+	// JumpPointSearch path into m_PathCells when there's no danger between the two cells, false to leave it to m_pPlanner
+	bool FindOpenGroundPath(int startIdx, int goalIdx);
+
+	// Keeps its search between plans and repairs it with the cells whose danger moved (the map watches the DANGER layer)
+	std::unique_ptr<Elite::DStarLite<Elite::WorldNode, Elite::GraphConnection>> m_pPlanner{ nullptr };
+	float m_DangerPenalty{ .1f }; // extra cost per unit of danger, relative to the connection cost
+	// Trips over open ground (no danger in the box around start and destination) skip the repair and jump over the grid,
+	// down to m_OpenGroundDanger the penalty stays within 5% of the connection cost
+	std::unique_ptr<Elite::JumpPointSearch<Elite::WorldNode, Elite::GraphConnection>> m_pOpenGroundPlanner{ nullptr };
+	float m_OpenGroundDanger{ -.5f };
+	std::vector<Elite::WorldNode*> m_OpenGroundPath{};
+	Elite::Vector2 m_Destination{};
+	std::vector<int> m_PathCells{};
+	std::vector<int> m_ChangedCells{};
+	std::vector<Elite::Vector2> m_Waypoints{};
+	size_t m_WaypointIdx{ 0 };
+	float m_ReplanInterval{ .2f };
+	float m_TimeSinceReplan{ 0.f };
+	bool m_NeedsReplan{ true };
+};
+
 ///////////////////////////////////////
 //NAVIGATE INFLUENCE
 //****